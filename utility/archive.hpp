@@ -18,8 +18,12 @@
 
 #pragma once
 #include "solid/utility/function.hpp"
+#include <chrono>
+#include <ctime>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace myapps {
@@ -31,16 +35,292 @@ using FileWriteFunctionT         = solid::Function<bool(const char*, size_t)>;
 using OnCreateDirectoryFunctionT = solid::Function<bool(const char*)>;
 using CreateWriteFunctionT       = solid::Function<FileWriteFunctionT(const char*, uint64_t, const uint8_t*, uint16_t)>;
 using CreateFileMetaFunctionT    = solid::Function<void(const std::string&, std::vector<uint8_t>&)>;
+using ArchiveWriteFunctionT      = solid::Function<bool(const char*, size_t)>;
+
+enum struct ArchivePhaseE : uint8_t {
+    Scan,       // listing the source tree; bytes: sizes of the files found
+    Read,       // reading source files; bytes read
+    Compress,   // CRC and deflate; uncompressed bytes
+    Decompress, // reading archive entries, inflate and CRC; uncompressed bytes
+    Write,      // writing the archive or the extracted files; bytes written
+};
+
+constexpr size_t archive_phase_count = 5;
+
+const char* archive_phase_name(ArchivePhaseE _phase);
+
+struct ArchiveEntryEvent {
+    const char*                         name_            = nullptr;
+    uint64_t                            size_            = 0; // uncompressed
+    uint64_t                            compressed_size_ = 0; // as stored in the archive
+    std::chrono::steady_clock::duration duration_{}; // thread time spent on the entry
+};
+
+// Instrumentation of archive_create, archive_stream_create, archive_update and archive_extract,
+// see the pobserver_ options. The functions are called from the worker threads too, possibly
+// concurrently, so they must be thread safe. They are called per slice or per entry, never per
+// buffer, and no clock is read without an observer.
+struct ArchiveObserver {
+    using PhaseFunctionT = solid::Function<void(ArchivePhaseE, std::chrono::steady_clock::duration, uint64_t)>;
+    using EntryFunctionT = solid::Function<void(const ArchiveEntryEvent&)>;
+
+    PhaseFunctionT phase_fnc_; // time spent in a phase and the bytes it handled
+    EntryFunctionT entry_fnc_; // once per file entry, after it was written or extracted
+};
+
+// Built-in ArchiveObserver aggregating everything with atomics.
+// Phase times add up over threads, so a phase's MB/s is per thread; the overall MB/s uses
+// the wall time since construction or reset().
+class ArchiveStatistics {
+    struct Data;
+    std::unique_ptr<Data> pimpl_;
+
+public:
+    ArchiveStatistics();
+    ~ArchiveStatistics();
+
+    ArchiveStatistics(const ArchiveStatistics&)            = delete;
+    ArchiveStatistics& operator=(const ArchiveStatistics&) = delete;
+
+    ArchiveObserver* observer();
+
+    void reset();
+
+    uint64_t                            entryCount() const;
+    uint64_t                            entrySize() const;
+    uint64_t                            bytes(ArchivePhaseE _phase) const;
+    std::chrono::steady_clock::duration time(ArchivePhaseE _phase) const;
+    std::chrono::steady_clock::duration elapsed() const;
+
+    // e.g. "400 entries 1.2 MB in 0.031 s 38.7 MB/s; scan 0.002 s 600.0 MB/s; read ..."
+    std::string report() const;
+};
+
+// lower case extensions of already compressed formats (images, audio, video, archives)
+std::vector<std::string> archive_default_store_extensions();
+
+struct ArchiveCreateOptions {
+    // N threads (0: one) read and deflate the files while the calling thread writes the
+    // archive progressively, in order; a failing entry stops the creation right away
+    size_t worker_count_ = 0;
+    // uncompressed bytes the workers may hold ahead of the writer (0: no limit but 4 slices per
+    // worker); with chunk_size_ it puts a ceiling on memory, whatever the tree.
+    // Each worker keeps at most one source file open.
+    uint64_t read_ahead_size_ = 32 * 1024 * 1024;
+    // files bigger than this are deflated as independent slices so they spread over workers
+    size_t chunk_size_ = 1024 * 1024;
+    // zlib level used by the worker threads
+    int compression_level_ = -1;
+    // files with these extensions are stored uncompressed without trying
+    std::vector<std::string> store_extensions_ = archive_default_store_extensions();
+    // other files get the first sample_size_ bytes deflated (files within one slice: the whole
+    // file) and are stored if that does not go below store_ratio_ of the input; 0 disables it
+    size_t sample_size_ = 64 * 1024;
+    double store_ratio_ = 0.95;
+    // threads listing the source tree; 0: worker_count_ (at least one)
+    size_t scan_thread_count_ = 0;
+    // computed while the archive is written, see ArchiveCreateResult
+    bool compute_sha_sum_      = false;
+    bool compute_file_digests_ = false;
+    // solid mode: files smaller than solid_file_size_ (0: off) are concatenated into shared
+    // deflate blocks of about solid_block_size_ bytes; the extraction functions restore them
+    uint64_t solid_file_size_  = 0;
+    uint64_t solid_block_size_ = 1024 * 1024;
+    // files with the same content as an earlier one (same size, then same sha256) are stored
+    // once; the copies become aliases written by the extraction functions along with the file
+    // they duplicate, see ArchiveExtractOptions::hardlink_aliases_
+    bool deduplicate_ = false;
+    // a manifest entry written last, see archive_read_manifest
+    bool write_manifest_ = false;
+    // not owned
+    ArchiveObserver* pobserver_ = nullptr;
+};
+
+struct ArchiveCreateResult {
+    // utility::sha256 of the archive bytes - the value for CreateBuildRequest::sha_sum_
+    std::string sha_sum_;
+    // (entry name, utility::sha256 of the file content) for every file entry, in archive order;
+    // in solid mode the digest of a block covers its members
+    std::vector<std::pair<std::string, std::string>> file_digests_;
+};
 
 bool archive_create(
     const std::string& _path, std::string _root, uint64_t& _runcompressed_size,
     CreateFileMetaFunctionT _meta_fnc = [](const std::string&, std::vector<uint8_t>&) {});
 
+// _meta_fnc is always called on the calling thread, once per file in name order, before any
+// entry is written
+bool archive_create(
+    const std::string& _path, std::string _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options,
+    CreateFileMetaFunctionT     _meta_fnc = [](const std::string&, std::vector<uint8_t>&) {});
+
+// the digests enabled in _options are computed in the same pass that writes the archive
+bool archive_create(
+    const std::string& _path, std::string _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options, ArchiveCreateResult& _rresult,
+    CreateFileMetaFunctionT _meta_fnc = [](const std::string&, std::vector<uint8_t>&) {});
+
+// Emit the archive progressively, strictly in order, while it is being compressed - the target
+// needs no seeking so it can be a socket or an upload stream.
+// Compression always runs on at least one worker thread; _write_fnc is called on the calling thread.
+bool archive_stream_create(
+    ArchiveWriteFunctionT _write_fnc, std::string _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options,
+    CreateFileMetaFunctionT     _meta_fnc = [](const std::string&, std::vector<uint8_t>&) {});
+
+bool archive_stream_create(
+    std::ostream& _ros, std::string _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options,
+    CreateFileMetaFunctionT     _meta_fnc = [](const std::string&, std::vector<uint8_t>&) {});
+
+// Selects entries by name: an entry is taken if it matches one of patterns_ (any when empty)
+// and predicate_, when set, accepts it (name, uncompressed size).
+// A pattern ending in '/' takes that whole subtree; any other is a glob matched against the
+// whole name where '?' matches one character, '*' any run within a path component and
+// '**' any run across components. Directories holding a taken entry are always taken.
+struct ArchiveEntryFilter {
+    using PredicateT = solid::Function<bool(const std::string&, uint64_t)>;
+
+    std::vector<std::string> patterns_;
+    PredicateT               predicate_;
+
+    bool empty() const { return patterns_.empty() && !predicate_; }
+
+    bool operator()(const std::string& _name, uint64_t _size) const;
+};
+
+struct ArchiveListEntry {
+    std::string name_; // directories end with '/'
+    uint64_t    size_  = 0;
+    time_t      mtime_ = 0;
+};
+
+// Names, uncompressed sizes and mtimes of the entries _filter takes, in archive order,
+// straight from the central directory - nothing is decompressed but the small solid index,
+// whose members are listed in place of their blocks.
+bool archive_list(const std::string& _path, std::vector<ArchiveListEntry>& _rentries, const ArchiveEntryFilter& _filter = ArchiveEntryFilter{});
+
+class ArchiveCache;
+
+struct ArchiveListOptions {
+    // the whole subtree under the prefix rather than its children only
+    bool recursive_ = false;
+    // not owned; keeps the parsed central directory and listing index of the archive
+    // between calls
+    ArchiveCache* pcache_ = nullptr;
+};
+
+// One directory of the archive, _prefix ("" for the root, "a/b" or "a/b/" below it): its
+// files, solid members and aliases, and its subdirectories - stored or only implied by the
+// names below them - named relative to _prefix and sorted by name. Like the listing above,
+// only the central directory and the small solid and alias indexes are read.
+// False when the archive cannot be read or _prefix names no directory in it.
+bool archive_list(const std::string& _path, const std::string& _prefix, std::vector<ArchiveListEntry>& _rentries, const ArchiveListOptions& _options = ArchiveListOptions{});
+
+struct ArchiveManifestEntry {
+    std::string          name_; // directories end with '/'
+    uint64_t             size_  = 0;
+    time_t               mtime_ = 0;
+    uint32_t             crc_   = 0; // 0 for solid members, covered by their block
+    std::string          digest_; // with compute_file_digests_, empty for solid members
+    std::vector<uint8_t> meta_;
+};
+
+// Every entry of an archive created with write_manifest_, solid members included, with its
+// meta, from the columnar manifest entry at the end of the archive: no local header is read.
+// False if the archive has no manifest.
+bool archive_read_manifest(const std::string& _path, std::vector<ArchiveManifestEntry>& _rentries);
+
+struct ArchiveVerifyOptions {
+    using MetaFunctionT = solid::Function<bool(const std::string&, const std::vector<uint8_t>&)>;
+
+    // 0: one thread per core
+    size_t worker_count_ = 0;
+    // when set, called with the name and the meta extra field of every file, solid members
+    // included, from the worker threads; false fails the verification
+    MetaFunctionT meta_fnc_;
+};
+
+struct ArchiveVerifyResult {
+    // the first failing entry in archive order among those checked, empty when the archive
+    // fails as a whole (no central directory, bad solid index or manifest)
+    std::string entry_name_;
+    std::string error_;
+    size_t      entry_count_ = 0;
+    uint64_t    size_        = 0; // uncompressed bytes checked
+};
+
+// Checks an archive without extracting it: every entry is decompressed in parallel into a
+// null sink, its size and CRC checked, its local header and extra fields validated; solid
+// blocks must match their index and the manifest, if any, the central directory.
+// Only the archive is read.
+bool archive_verify(const std::string& _path, ArchiveVerifyResult& _rresult, const ArchiveVerifyOptions& _options = ArchiveVerifyOptions{});
+
+struct ArchiveExtractOptions {
+    // 0: every entry is extracted on the calling thread, in archive order
+    // N: see do_archive_extract below
+    size_t worker_count_ = 0;
+    // archive_extract without callbacks only: stored entries are copied file to file inside
+    // the kernel (copy_file_range, sendfile) without passing through user space buffers;
+    // their CRC is still checked, reading the copied range back from the archive, which
+    // only pays off where the copy itself is cheap (reflinks, network file systems)
+    bool zero_copy_ = false;
+    // archive_extract without callbacks only: files are preallocated to their final size and
+    // written through a buffer of this size, small files with a single write call
+    size_t write_buffer_size_ = 1024 * 1024;
+    // archive_extract without callbacks only: the extracted tree is durable on return;
+    // file data is flushed once per filesystem and each directory once, not file by file
+    bool sync_ = false;
+    // archive_extract without callbacks only: completed entries are recorded in this sidecar
+    // file; run again after an interruption, the extraction skips the recorded entries whose
+    // files are still on disk with their size. Removed once the extraction succeeds.
+    // Meant for a killed or crashed process: it does not make the output durable, see sync_.
+    std::string journal_path_;
+    // entries not taken are skipped without being read or decompressed and are not counted in
+    // _runcompressed_size; a solid block is decompressed if any of its members is taken
+    ArchiveEntryFilter filter_;
+    // archive_extract without callbacks only: aliases of duplicate files (see
+    // ArchiveCreateOptions::deduplicate_) become hard links to their target rather than copies
+    bool hardlink_aliases_ = false;
+    // not owned; Write is the time spent in the file writers, Decompress the rest of an entry
+    ArchiveObserver* pobserver_ = nullptr;
+};
+
+struct ArchiveUpdateOptions {
+    // compression settings for new and modified files; at least one worker is always used
+    ArchiveCreateOptions create_;
+    // besides size and modification time, compare the file CRC32 against the archived one;
+    // reads every seemingly unchanged file once
+    bool check_crc_ = false;
+};
+
+// Build _new_path from _root reusing _old_path: files whose size and modification time (and
+// CRC32 with check_crc_) match their previous entry are copied still compressed, only new and
+// modified files are compressed. _meta_fnc is called for every file, like archive_create.
+bool archive_update(
+    const std::string& _old_path, std::string _root, const std::string& _new_path, uint64_t& _runcompressed_size,
+    const ArchiveUpdateOptions& _options  = ArchiveUpdateOptions{},
+    CreateFileMetaFunctionT     _meta_fnc = [](const std::string&, std::vector<uint8_t>&) {});
+
 bool do_archive_extract(
     const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size,
     OnCreateDirectoryFunctionT& _on_create_dir_function,
     CreateWriteFunctionT&       _create_file_writer_function);
 
+// With _options.worker_count_ != 0:
+// - all directories are created first, on the calling thread, in archive order,
+//   each followed by _on_create_dir_function;
+// - file entries are then spread over worker_count_ threads, each with its own archive handle,
+//   biggest files first;
+// - _create_file_writer_function is called on the worker threads but never concurrently;
+// - the returned FileWriteFunctionT is called and destroyed only on the worker thread that created it.
+bool do_archive_extract(
+    const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size,
+    const ArchiveExtractOptions& _options,
+    OnCreateDirectoryFunctionT&  _on_create_dir_function,
+    CreateWriteFunctionT&        _create_file_writer_function);
+
 template <class CreateDirFnc, class CreateWriteFnc>
 bool archive_extract(const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size, CreateDirFnc _create_dir_fnc, CreateWriteFnc _create_write_fnc)
 {
@@ -49,7 +329,46 @@ bool archive_extract(const std::string& _path, const std::string& _root, uint64_
     return do_archive_extract(_path, _root, _runcompressed_size, create_dir_fnc, create_write_fnc);
 }
 
+template <class CreateDirFnc, class CreateWriteFnc>
+bool archive_extract(const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size, const ArchiveExtractOptions& _options, CreateDirFnc _create_dir_fnc, CreateWriteFnc _create_write_fnc)
+{
+    OnCreateDirectoryFunctionT create_dir_fnc(_create_dir_fnc);
+    CreateWriteFunctionT       create_write_fnc(_create_write_fnc);
+    return do_archive_extract(_path, _root, _runcompressed_size, _options, create_dir_fnc, create_write_fnc);
+}
+
 bool archive_extract(const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size);
 
+bool archive_extract(const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size, const ArchiveExtractOptions& _options);
+
+// Extracts an archive while it is still arriving, e.g. chunk by chunk from FetchStoreResponse.
+// Entries are consumed in local header order, so no seeking and no central directory are needed;
+// every file is handed to its FileWriteFunctionT as soon as its bytes were pushed and the writer
+// is released once the entry is complete and its CRC checked.
+// All callbacks are called from within push(), on the pushing thread.
+class ArchiveStreamExtractor {
+    struct Data;
+    std::unique_ptr<Data> pimpl_;
+
+public:
+    ArchiveStreamExtractor(
+        const std::string& _root, OnCreateDirectoryFunctionT&& _on_create_dir_function,
+        CreateWriteFunctionT&& _create_file_writer_function);
+
+    explicit ArchiveStreamExtractor(const std::string& _root);
+
+    ~ArchiveStreamExtractor();
+
+    // false once the archive is found invalid or a callback fails; the extractor stays failed
+    bool push(const char* _data, size_t _size);
+
+    // true if the whole archive was pushed - all entries up to the central directory
+    bool done() const;
+
+    bool failed() const;
+
+    uint64_t uncompressedSize() const;
+};
+
 } // namespace utility
 } // namespace myapps
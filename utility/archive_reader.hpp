@@ -0,0 +1,132 @@
+// myapps/common/utility/archive_reader.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+
+struct ArchiveListEntry;
+
+struct ArchiveEntry {
+    std::string name_;
+    uint64_t    size_            = 0;
+    uint64_t    compressed_size_ = 0;
+    uint64_t    local_offset_    = 0;
+    time_t      mtime_           = 0;
+    uint32_t    crc_             = 0;
+    uint16_t    method_          = 0;
+
+    bool isDirectory() const { return !name_.empty() && name_.back() == '/'; }
+};
+
+// Random access to a zip archive.
+// open() reads the central directory once and sorts a name index over it, so
+// find() and readFile() cost O(log n) regardless of the number of entries.
+// All const methods may be called concurrently.
+class ArchiveReader {
+    struct Data;
+    std::unique_ptr<Data> pimpl_;
+
+public:
+    ArchiveReader();
+    ~ArchiveReader();
+
+    ArchiveReader(ArchiveReader&&) noexcept;
+    ArchiveReader& operator=(ArchiveReader&&) noexcept;
+
+    bool open(const std::string& _path);
+    void close();
+
+    bool isOpen() const;
+
+    // entries in central directory order
+    size_t              entryCount() const;
+    const ArchiveEntry& entry(size_t _index) const;
+
+    const ArchiveEntry* find(std::string_view _name) const;
+
+    // _rdata receives at most _len bytes of the entry content starting at _offset;
+    // the crc is checked when the whole entry is read
+    bool readFile(const ArchiveEntry& _rentry, uint64_t _offset, uint64_t _len, std::string& _rdata) const;
+    bool readFile(std::string_view _name, uint64_t _offset, uint64_t _len, std::string& _rdata) const;
+    bool readFile(std::string_view _name, std::string& _rdata) const;
+
+    // the meta extra field from the local header
+    bool readMeta(const ArchiveEntry& _rentry, std::vector<uint8_t>& _rmeta) const;
+    // archive offset of the first byte of the entry data
+    bool dataOffset(const ArchiveEntry& _rentry, uint64_t& _roffset) const;
+    // the compressed_size_ bytes of entry data as stored, _rentry.method_ tells how
+    bool readRaw(const ArchiveEntry& _rentry, std::string& _rdata) const;
+};
+
+// Bytes handed out by ArchiveCache; they stay valid after eviction for as long as they are held.
+struct ArchiveCacheData {
+    std::shared_ptr<const char> pdata_;
+    size_t                      size_ = 0;
+
+    std::string_view view() const { return std::string_view(pdata_.get(), size_); }
+};
+
+// In-memory images of hot archives, shared by all the readers of a process.
+// Each archive gets an ArchiveReader (its name index) on first use; entry bytes, decompressed
+// or raw as stored, are packed into arena blocks. Blocks and the indexes of every open archive
+// are charged against one memory budget and evicted least recently used first across all
+// archives: block by block, or a whole idle archive with its blocks, closing it. Solid members
+// and aliases are served from their cached block or target. Entries, or archive indexes,
+// bigger than the budget are read without being cached. All methods may be called concurrently.
+class ArchiveCache {
+    struct Data;
+    std::unique_ptr<Data> pimpl_;
+
+public:
+    explicit ArchiveCache(uint64_t _capacity);
+    ~ArchiveCache();
+
+    ArchiveCache(const ArchiveCache&)            = delete;
+    ArchiveCache& operator=(const ArchiveCache&) = delete;
+
+    // the uncompressed content of _name, solid members included
+    bool readFile(const std::string& _path, std::string_view _name, ArchiveCacheData& _rdata);
+    // the entry data as stored, for sending it on without inflating it; _rentry receives the
+    // central directory record. Solid members have no raw form of their own.
+    bool readRaw(const std::string& _path, std::string_view _name, ArchiveCacheData& _rdata, ArchiveEntry& _rentry);
+
+    // archive_list of a directory over the listing index built on first use, see
+    // ArchiveListOptions::pcache_
+    bool list(const std::string& _path, const std::string& _prefix, bool _recursive, std::vector<ArchiveListEntry>& _rentries);
+
+    // forget an archive, e.g. once it is replaced on disk; data already handed out stays valid
+    void erase(const std::string& _path);
+    void clear();
+
+    uint64_t capacity() const;
+    uint64_t size() const; // bytes of arena blocks and archive indexes held
+    size_t   imageCount() const; // archives held open
+    uint64_t hitCount() const;
+    uint64_t missCount() const;
+};
+
+} // namespace utility
+} // namespace myapps
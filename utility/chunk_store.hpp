@@ -0,0 +1,71 @@
+// myapps/common/utility/chunk_store.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "myapps/common/utility/archive.hpp"
+#include <string>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+
+// Deduplicating build container, an alternative to the zip archive.
+// Files are cut into content defined chunks (gear rolling hash, 16KB min, 64KB average,
+// 256KB max) stored once per digest under _store_path/<xx>/<hex digest>.
+// A build is a manifest file listing its directories and files with their chunk digests, so two
+// builds sharing most of their bytes share most of their chunks.
+
+struct ChunkStoreStatistics {
+    uint64_t chunk_count_     = 0; // chunk references in the manifest
+    uint64_t new_chunk_count_ = 0; // chunks that were not yet in the store
+    uint64_t new_chunk_size_  = 0; // bytes written to the store for the new chunks
+};
+
+bool chunk_store_create(
+    const std::string& _store_path, const std::string& _manifest_path, std::string _root,
+    uint64_t& _runcompressed_size, ChunkStoreStatistics& _rstatistics,
+    CreateFileMetaFunctionT _meta_fnc = [](const std::string&, std::vector<uint8_t>&) {});
+
+bool chunk_store_create(
+    const std::string& _store_path, const std::string& _manifest_path, std::string _root,
+    uint64_t&               _runcompressed_size,
+    CreateFileMetaFunctionT _meta_fnc = [](const std::string&, std::vector<uint8_t>&) {});
+
+// hex digests referenced by the manifest and not present in _store_path - what has to be transferred
+bool chunk_store_missing(const std::string& _store_path, const std::string& _manifest_path, std::vector<std::string>& _rdigests);
+
+bool do_chunk_store_extract(
+    const std::string& _store_path, const std::string& _manifest_path, const std::string& _root,
+    uint64_t&                   _runcompressed_size,
+    OnCreateDirectoryFunctionT& _on_create_dir_function,
+    CreateWriteFunctionT&       _create_file_writer_function);
+
+template <class CreateDirFnc, class CreateWriteFnc>
+bool chunk_store_extract(
+    const std::string& _store_path, const std::string& _manifest_path, const std::string& _root,
+    uint64_t& _runcompressed_size, CreateDirFnc _create_dir_fnc, CreateWriteFnc _create_write_fnc)
+{
+    OnCreateDirectoryFunctionT create_dir_fnc(_create_dir_fnc);
+    CreateWriteFunctionT       create_write_fnc(_create_write_fnc);
+    return do_chunk_store_extract(_store_path, _manifest_path, _root, _runcompressed_size, create_dir_fnc, create_write_fnc);
+}
+
+bool chunk_store_extract(const std::string& _store_path, const std::string& _manifest_path, const std::string& _root, uint64_t& _runcompressed_size);
+
+} // namespace utility
+} // namespace myapps
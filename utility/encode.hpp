@@ -19,6 +19,7 @@
 #pragma once
 
 #include <istream>
+#include <memory>
 #include <string>
 
 namespace myapps {
@@ -28,6 +29,23 @@ namespace utility {
 std::string sha256(const std::string& str);
 std::string sha256(std::istream& _ris);
 
+// incremental sha256(): same digest, for data that arrives in pieces
+class Sha256Hasher {
+    struct Data;
+    std::unique_ptr<Data> pimpl_;
+
+public:
+    Sha256Hasher();
+    ~Sha256Hasher();
+
+    Sha256Hasher(Sha256Hasher&&) noexcept;
+    Sha256Hasher& operator=(Sha256Hasher&&) noexcept;
+
+    void update(const char* _data, size_t _size);
+    // returns the digest and starts over
+    std::string digest();
+};
+
 std::string base64_encode(const std::string_view& _txt);
 std::string base64_decode(const std::string_view& _txt);
 
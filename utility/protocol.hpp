@@ -27,6 +27,7 @@
 #include <vector>
 
 #include "cereal/cereal.hpp"
+#include "myapps/common/utility/archive.hpp"
 #include "solid/frame/mprpc/mprpcmessage.hpp"
 #include "solid/reflection/v1/reflection.hpp"
 #include "solid/system/cassert.hpp"
@@ -709,6 +710,14 @@ struct ListStoreNode {
     }
 };
 
+// the nodes of a listing served from an archive, see archive_list of a directory
+inline void list_store_nodes(const std::vector<ArchiveListEntry>& _entries, std::deque<ListStoreNode>& _rnodes)
+{
+    for (const auto& entry : _entries) {
+        _rnodes.emplace_back(entry.name_, entry.size_, static_cast<int64_t>(entry.mtime_));
+    }
+}
+
 enum struct AppFlagE {
     ReviewRequest = 0,
     Owned,
@@ -16,187 +16,1507 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include "archive_alias.hpp"
+#include "archive_files.hpp"
+#include "archive_manifest.hpp"
+#include "archive_observer.hpp"
+#include "crc32.hpp"
+#include "entry_selection.hpp"
 #include "myapps/common/utility/archive.hpp"
+#include "myapps/common/utility/encode.hpp"
 #include "solid/system/log.hpp"
+#include "solid_block.hpp"
 #include "zip.h"
+#include "zip_format.hpp"
+#include "zip_writer.hpp"
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <zlib.h>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
 
 using namespace std;
 
 namespace myapps {
 namespace utility {
 namespace {
-constexpr uint16_t meta_extra_field_id = 0x3333;
-solid::LoggerT     logger("myapps::utility::archive");
+using zip::meta_extra_field_id;
+solid::LoggerT logger("myapps::utility::archive");
 //-----------------------------------------------------------------------------
+} // namespace
 
-bool zip_add_file(
-    zip_t* _pzip, const boost::filesystem::path& _path, size_t _base_path_len, uint64_t& _rsize,
-    const CreateFileMetaFunctionT& _rmeta_fnc, vector<uint8_t>& _rmeta_data)
-{
-    string        path = _path.generic_string();
-    zip_source_t* psrc = zip_source_file(_pzip, path.c_str(), 0, 0);
-    if (psrc != nullptr) {
-        _rsize += file_size(_path);
-        zip_int64_t index = zip_file_add(_pzip, (path.c_str() + _base_path_len), psrc, ZIP_FL_ENC_UTF_8);
-        solid_log(logger, Info, "" << (path.c_str() + _base_path_len) << " rv = " << index);
-        if (index < 0) {
-            zip_source_free(psrc);
-        } else {
-            _rmeta_data.clear();
-            _rmeta_fnc(path, _rmeta_data);
-            if (!_rmeta_data.empty()) {
-                zip_file_extra_field_set(_pzip, index, meta_extra_field_id, 0, _rmeta_data.data(), _rmeta_data.size(), ZIP_FL_LOCAL);
+std::vector<std::string> archive_default_store_extensions()
+{
+    return {
+        "png", "jpg", "jpeg", "gif", "webp", "avif", "heic", "jxl",
+        "mp3", "m4a", "aac", "ogg", "oga", "opus", "flac", "wma",
+        "mp4", "m4v", "mkv", "webm", "avi", "mov", "ogv", "wmv",
+        "zip", "gz", "tgz", "bz2", "xz", "7z", "rar", "zst", "lz4", "br",
+        "jar", "apk", "cab", "msi", "woff", "woff2"};
+}
+
+namespace {
+
+bool is_store_extension(const boost::filesystem::path& _path, const ArchiveCreateOptions& _options)
+{
+    string ext = _path.extension().string();
+    if (ext.size() < 2) {
+        return false;
+    }
+    ext.erase(0, 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char _c) { return static_cast<char>(std::tolower(_c)); });
+    return std::find(_options.store_extensions_.begin(), _options.store_extensions_.end(), ext) != _options.store_extensions_.end();
+}
+
+bool is_incompressible(const uint64_t _size, const uint64_t _compressed_size, const ArchiveCreateOptions& _options)
+{
+    return static_cast<double>(_compressed_size) >= static_cast<double>(_size) * _options.store_ratio_;
+}
+
+// deflate the first sample_size_ bytes at the fastest level and see if they shrink
+bool sample_incompressible(const boost::filesystem::path& _path, const ArchiveCreateOptions& _options)
+{
+    if (_options.sample_size_ == 0) {
+        return false;
+    }
+    string                      in(_options.sample_size_, '\0');
+    boost::filesystem::ifstream ifs(_path, std::ios::binary);
+    ifs.read(&in[0], in.size());
+    in.resize(ifs.gcount());
+    if (in.empty()) {
+        return false;
+    }
+    uLongf out_len = compressBound(in.size());
+    string out(out_len, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(&out[0]), &out_len, reinterpret_cast<const Bytef*>(in.data()), in.size(), Z_BEST_SPEED) != Z_OK) {
+        return false;
+    }
+    return is_incompressible(in.size(), out_len, _options);
+}
+
+bool should_store(const boost::filesystem::path& _path, const ArchiveCreateOptions& _options)
+{
+    return is_store_extension(_path, _options) || sample_incompressible(_path, _options);
+}
+
+//-----------------------------------------------------------------------------
+
+struct ZipCloser {
+    void operator()(zip_t* _pzip) const
+    {
+        zip_discard(_pzip);
+    }
+};
+
+struct ZipFileCloser {
+    void operator()(zip_file_t* _pzf) const
+    {
+        zip_fclose(_pzf);
+    }
+};
+
+using ZipPtrT     = std::unique_ptr<zip_t, ZipCloser>;
+using ZipFilePtrT = std::unique_ptr<zip_file_t, ZipFileCloser>;
+
+ZipPtrT zip_open_read(const std::string& _zip_path)
+{
+    int    err;
+    zip_t* pzip = zip_open(_zip_path.c_str(), ZIP_RDONLY, &err);
+    if (pzip == nullptr) {
+        zip_error_t error;
+        zip_error_init_with_code(&error, err);
+        solid_log(logger, Error, "Opening archive: " << _zip_path << ": " << zip_error_strerror(&error));
+        zip_error_fini(&error);
+    }
+    return ZipPtrT(pzip);
+}
+
+//-----------------------------------------------------------------------------
+// Tree scan
+//-----------------------------------------------------------------------------
+
+struct CreateEntry {
+    boost::filesystem::path path_;
+    string                  name_;
+    uint64_t                size_         = 0;
+    time_t                  mtime_        = 0;
+    bool                    is_directory_ = false;
+    size_t                  job_begin_    = 0;
+    size_t                  job_end_      = 0;
+    uint16_t                method_       = zip::method_deflate;
+    // entry copied still compressed from a previous archive (archive_update)
+    int64_t  source_index_           = -1;
+    uint32_t source_crc_             = 0;
+    uint64_t source_compressed_size_ = 0;
+    // solid block: (path, size) of the files concatenated into this entry
+    vector<pair<boost::filesystem::path, uint64_t>> solid_members_;
+    // has aliases, see AliasIndex: kept out of solid blocks
+    bool alias_target_ = false;
+    // from _meta_fnc, see archive_meta
+    vector<uint8_t> meta_;
+};
+
+bool stat_entry(CreateEntry& _rentry)
+{
+#ifdef _WIN32
+    boost::system::error_code err;
+    _rentry.is_directory_ = boost::filesystem::is_directory(_rentry.path_, err);
+    if (!err) {
+        _rentry.mtime_ = boost::filesystem::last_write_time(_rentry.path_, err);
+    }
+    if (!err && !_rentry.is_directory_) {
+        _rentry.size_ = boost::filesystem::file_size(_rentry.path_, err);
+    }
+    return !err;
+#else
+    // type, size and time from a single stat call
+    struct stat st;
+    if (::stat(_rentry.path_.c_str(), &st) != 0) {
+        return false;
+    }
+    _rentry.is_directory_ = S_ISDIR(st.st_mode);
+    _rentry.size_         = _rentry.is_directory_ ? 0 : static_cast<uint64_t>(st.st_size);
+    _rentry.mtime_        = st.st_mtime;
+    return true;
+#endif
+}
+
+bool scan_directory(
+    const boost::filesystem::path& _path, const size_t _base_path_len,
+    vector<CreateEntry>& _rentries, vector<boost::filesystem::path>& _rsubdirs)
+{
+    using namespace boost::filesystem;
+
+    boost::system::error_code err;
+    for (directory_iterator it(_path, err), end; !err && it != end; it.increment(err)) {
+        CreateEntry entry;
+        entry.path_ = it->path();
+        entry.name_ = entry.path_.generic_string().substr(_base_path_len);
+        if (!stat_entry(entry)) {
+            solid_log(logger, Error, "Cannot stat: " << entry.path_.generic_string());
+            return false;
+        }
+        if (entry.is_directory_) {
+            entry.name_ += '/';
+            _rsubdirs.emplace_back(entry.path_);
+        }
+        _rentries.emplace_back(std::move(entry));
+    }
+    if (err) {
+        solid_log(logger, Error, "Cannot list: " << _path.generic_string() << ": " << err.message());
+        return false;
+    }
+    return true;
+}
+
+// Directories are listed by _thread_count threads; the result is sorted by name - independent
+// of readdir order and of thread timing, and every directory comes before its content.
+bool scan_tree(const std::string& _root, vector<CreateEntry>& _rentries, const size_t _thread_count)
+{
+    mutex                          mtx;
+    condition_variable             cnd;
+    deque<boost::filesystem::path> dirs{boost::filesystem::path(_root)};
+    size_t                         busy   = 0;
+    bool                           failed = false;
+
+    auto worker_lambda = [&]() {
+        vector<CreateEntry>             entries;
+        vector<boost::filesystem::path> subdirs;
+        unique_lock<mutex>              lock(mtx);
+        while (true) {
+            cnd.wait(lock, [&]() { return failed || !dirs.empty() || busy == 0; });
+            if (failed || dirs.empty()) {
+                break;
+            }
+            const auto dir = std::move(dirs.front());
+            dirs.pop_front();
+            ++busy;
+            lock.unlock();
+
+            const bool ok = scan_directory(dir, _root.size(), entries, subdirs);
+
+            lock.lock();
+            --busy;
+            failed = failed || !ok;
+            for (auto& subdir : subdirs) {
+                dirs.emplace_back(std::move(subdir));
             }
+            subdirs.clear();
+            cnd.notify_all();
+        }
+        std::move(entries.begin(), entries.end(), std::back_inserter(_rentries));
+    };
+
+    const size_t thread_count = std::max<size_t>(_thread_count, 1);
+    if (thread_count == 1) {
+        worker_lambda();
+    } else {
+        vector<thread> threads;
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back(worker_lambda);
         }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+    if (failed) {
+        return false;
+    }
+    // extraction would take such a file for one of the archive's own entries
+    for (const auto& entry : _rentries) {
+        if (SolidIndex::isReservedName(entry.name_) || AliasIndex::isName(entry.name_) || ArchiveManifest::isName(entry.name_)) {
+            solid_log(logger, Error, "Reserved name: " << entry.name_);
+            return false;
+        }
+    }
+    std::sort(_rentries.begin(), _rentries.end(), [](const CreateEntry& _a, const CreateEntry& _b) { return _a.name_ < _b.name_; });
+    return true;
+}
+
+bool archive_scan(const std::string& _root, uint64_t& _runcompressed_size, vector<CreateEntry>& _rentries, const ArchiveCreateOptions& _options)
+{
+    boost::system::error_code err;
+
+    if (!boost::filesystem::is_directory(_root, err)) {
+        solid_log(logger, Error, "Path: " << _root << " not a directory");
+        return false;
+    }
+
+    ObserverClock clock(_options.pobserver_);
+
+    if (!scan_tree(_root, _rentries, _options.scan_thread_count_ != 0 ? _options.scan_thread_count_ : _options.worker_count_)) {
+        return false;
+    }
+
+    uint64_t size = 0;
+    for (const auto& entry : _rentries) {
+        size += entry.size_;
     }
+    _runcompressed_size += size;
+    clock.lap(ArchivePhaseE::Scan, size);
     return true;
 }
 
 //-----------------------------------------------------------------------------
 
-bool zip_add_dir(
-    zip_t* _pzip, const boost::filesystem::path& _path, size_t _base_path_len, uint64_t& _rsize,
-    const CreateFileMetaFunctionT& _rmeta_fnc, vector<uint8_t>& _rmeta_data)
+//-----------------------------------------------------------------------------
+// Parallel creation pipeline
+//-----------------------------------------------------------------------------
+
+struct CreateJob {
+    size_t   entry_index_ = 0;
+    uint64_t offset_      = 0;
+    size_t   size_        = 0;
+    bool     last_        = false;
+    string   data_;
+    string   raw_; // uncompressed slice, kept for the file digest when data_ is deflated
+    uint32_t crc_    = 0;
+    uint16_t method_ = zip::method_deflate;
+    bool     done_   = false;
+    bool     ok_     = false;
+    // worker time, with an observer
+    std::chrono::steady_clock::duration duration_{};
+};
+
+bool read_file_data(const boost::filesystem::path& _path, const uint64_t _offset, char* _pbuf, const size_t _size)
 {
-    using namespace boost::filesystem;
-    string      path = _path.generic_string();
-    zip_int64_t err  = zip_dir_add(_pzip, (path.c_str() + _base_path_len), ZIP_FL_ENC_UTF_8);
+    boost::filesystem::ifstream ifs(_path, std::ios::binary);
+    ifs.seekg(_offset);
+    ifs.read(_pbuf, _size);
+    return ifs && static_cast<size_t>(ifs.gcount()) == _size;
+}
 
-    solid_log(logger, Info, "" << (path.c_str() + _base_path_len) << " rv = " << err);
+bool read_entry_data(const CreateEntry& _rentry, uint64_t _offset, char* _pbuf, size_t _size)
+{
+    if (_rentry.solid_members_.empty()) {
+        return read_file_data(_rentry.path_, _offset, _pbuf, _size);
+    }
+    for (const auto& member : _rentry.solid_members_) {
+        if (_size == 0) {
+            break;
+        }
+        if (_offset >= member.second) {
+            _offset -= member.second;
+            continue;
+        }
+        const size_t len = static_cast<size_t>(std::min<uint64_t>(member.second - _offset, _size));
+        if (!read_file_data(member.first, _offset, _pbuf, len)) {
+            return false;
+        }
+        _pbuf += len;
+        _size -= len;
+        _offset = 0;
+    }
+    return _size == 0;
+}
 
-    for (directory_entry& x : directory_iterator(_path)) {
-        auto p = x.path();
-        if (is_directory(p)) {
-            zip_add_dir(_pzip, p, _base_path_len, _rsize, _rmeta_fnc, _rmeta_data);
-        } else {
-            zip_add_file(_pzip, p, _base_path_len, _rsize, _rmeta_fnc, _rmeta_data);
+bool file_digest(const boost::filesystem::path& _path, string& _rdigest)
+{
+    boost::filesystem::ifstream ifs(_path, std::ios::binary);
+    constexpr size_t            bufcp = 1024 * 64;
+    char                        buf[bufcp];
+    Sha256Hasher                hasher;
+
+    while (ifs.read(buf, bufcp) || ifs.gcount() != 0) {
+        hasher.update(buf, static_cast<size_t>(ifs.gcount()));
+    }
+    _rdigest = hasher.digest();
+    return ifs.eof();
+}
+
+// Calls _rmeta_fnc for every file, on the calling thread and in archive order, before
+// deduplicate and solid_pack move the files around. Fails on a name or a meta the local
+// header could not carry.
+bool archive_meta(vector<CreateEntry>& _rentries, const CreateFileMetaFunctionT& _rmeta_fnc)
+{
+    for (auto& entry : _rentries) {
+        if (entry.is_directory_) {
+            continue;
+        }
+        _rmeta_fnc(entry.path_.generic_string(), entry.meta_);
+        if (entry.name_.size() > zip::max_u16 || entry.meta_.size() > zip::max_meta_size) {
+            solid_log(logger, Error, "Name or meta too long: " << entry.name_);
+            return false;
         }
     }
     return true;
 }
-} // namespace
 
-bool archive_create(
-    const std::string& _zip_path, std::string _root, uint64_t& _runcompressed_size,
-    CreateFileMetaFunctionT _meta_fnc)
+// Files with the same size, then the same digest as an earlier file are taken out of _rentries
+// into _rindex as aliases of that first one. Only files sharing their size with another are read.
+bool deduplicate(vector<CreateEntry>& _rentries, AliasIndex& _rindex)
 {
-    using namespace boost::filesystem;
+    unordered_map<uint64_t, vector<size_t>> size_map;
+    for (size_t i = 0; i < _rentries.size(); ++i) {
+        const auto& entry = _rentries[i];
+        if (!entry.is_directory_ && entry.size_ != 0 && entry.name_ != metadata_name) {
+            size_map[entry.size_].emplace_back(i);
+        }
+    }
 
-    int             err;
-    zip_t*          pzip = zip_open(_zip_path.c_str(), ZIP_CREATE | ZIP_EXCL, &err);
-    vector<uint8_t> meta_data;
+    vector<pair<size_t, size_t>> aliases; // (target, alias) entry indexes
+    for (const auto& item : size_map) {
+        if (item.second.size() < 2) {
+            continue;
+        }
+        unordered_map<string, size_t> digest_map;
+        string                        digest;
+        for (const auto index : item.second) {
+            if (!file_digest(_rentries[index].path_, digest)) {
+                solid_log(logger, Error, "Reading " << _rentries[index].path_ << " failed");
+                return false;
+            }
+            const auto result = digest_map.emplace(digest, index);
+            if (!result.second) {
+                aliases.emplace_back(result.first->second, index);
+            }
+        }
+    }
+    if (aliases.empty()) {
+        return true;
+    }
 
-    if (pzip == nullptr) {
-        zip_error_t error;
-        zip_error_init_with_code(&error, err);
-        solid_log(logger, Error, "Creating archive: " << zip_error_strerror(&error));
-        zip_error_fini(&error);
+    // grouped by target name, then in archive order
+    std::sort(aliases.begin(), aliases.end(), [&_rentries](const pair<size_t, size_t>& _a, const pair<size_t, size_t>& _b) {
+        const int cmp = _rentries[_a.first].name_.compare(_rentries[_b.first].name_);
+        return cmp < 0 || (cmp == 0 && _a.second < _b.second);
+    });
+    vector<bool>   removed(_rentries.size(), false);
+    vector<size_t> last_alias(_rentries.size(), 0); // by target
+    for (const auto& item : aliases) {
+        auto& target = _rentries[item.first];
+        auto& entry  = _rentries[item.second];
+        AliasMember member;
+        member.name_   = entry.name_;
+        member.target_ = target.name_;
+        member.size_   = entry.size_;
+        member.mtime_  = entry.mtime_;
+        member.meta_   = std::move(entry.meta_);
+        _rindex.add(std::move(member));
+
+        target.alias_target_   = true;
+        removed[item.second]   = true;
+        last_alias[item.first] = std::max(last_alias[item.first], item.second);
+    }
+
+    // a target moves where its last alias was - after the directories of all its aliases -
+    // so that extraction can write the aliases along with it
+    vector<size_t> moved(_rentries.size(), _rentries.size()); // last alias to target
+    for (size_t i = 0; i < _rentries.size(); ++i) {
+        if (_rentries[i].alias_target_ && last_alias[i] > i) {
+            moved[last_alias[i]] = i;
+        }
+    }
+    vector<CreateEntry> entries;
+    entries.reserve(_rentries.size() - aliases.size());
+    for (size_t i = 0; i < _rentries.size(); ++i) {
+        if (moved[i] != _rentries.size()) {
+            entries.emplace_back(std::move(_rentries[moved[i]]));
+        } else if (!removed[i] && !(_rentries[i].alias_target_ && last_alias[i] > i)) {
+            entries.emplace_back(std::move(_rentries[i]));
+        }
+    }
+    _rentries = std::move(entries);
+    solid_log(logger, Info, "Deduplicate: " << aliases.size() << " files stored as aliases");
+    return true;
+}
+
+// Replaces the small files of _rentries with solid block entries, each placed where its
+// last member was - after the directories of all its members - and describes the members
+// in _rindex.
+void solid_pack(vector<CreateEntry>& _rentries, const ArchiveCreateOptions& _options, SolidIndex& _rindex)
+{
+    vector<CreateEntry> entries;
+    CreateEntry         block_entry;
+    uint32_t            block = 0;
+
+    entries.reserve(_rentries.size());
+    for (auto& entry : _rentries) {
+        const bool member = !entry.is_directory_ && entry.source_index_ < 0 && entry.size_ != 0 && entry.size_ < _options.solid_file_size_
+            && entry.name_ != metadata_name && !entry.alias_target_ && !is_store_extension(entry.path_, _options);
+        if (!member) {
+            entries.emplace_back(std::move(entry));
+            continue;
+        }
+        if (!block_entry.solid_members_.empty() && block_entry.size_ + entry.size_ > _options.solid_block_size_) {
+            entries.emplace_back(std::move(block_entry));
+            block_entry = CreateEntry();
+            ++block;
+        }
+        block_entry.name_ = SolidIndex::blockName(block);
+
+        SolidMember solid_member;
+        solid_member.name_   = entry.name_;
+        solid_member.size_   = entry.size_;
+        solid_member.mtime_  = entry.mtime_;
+        solid_member.block_  = block;
+        solid_member.offset_ = block_entry.size_;
+        solid_member.meta_   = std::move(entry.meta_);
+        _rindex.add(std::move(solid_member));
+
+        block_entry.size_ += entry.size_;
+        block_entry.mtime_ = std::max(block_entry.mtime_, entry.mtime_);
+        block_entry.solid_members_.emplace_back(entry.path_, entry.size_);
+    }
+    if (!block_entry.solid_members_.empty()) {
+        entries.emplace_back(std::move(block_entry));
+    }
+    _rentries = std::move(entries);
+}
+
+bool write_solid_index(zip::Writer& _rwriter, const SolidIndex& _rindex, const vector<CreateEntry>& _rentries)
+{
+    const string data  = _rindex.store();
+    time_t       mtime = 0;
+    for (const auto& entry : _rentries) {
+        if (!entry.solid_members_.empty()) {
+            mtime = std::max(mtime, entry.mtime_);
+        }
+    }
+    return _rwriter.beginFile(SolidIndex::indexName(), mtime, zip::method_store, data.size(), nullptr, 0)
+        && _rwriter.write(data.data(), data.size())
+        && _rwriter.endFile(zip::crc32_update(0, data.data(), data.size()), data.size());
+}
+
+bool write_alias_index(zip::Writer& _rwriter, const AliasIndex& _rindex)
+{
+    const string data  = _rindex.store();
+    time_t       mtime = 0;
+    for (const auto& member : _rindex.members()) {
+        mtime = std::max(mtime, member.mtime_);
+    }
+    return _rwriter.beginFile(AliasIndex::name(), mtime, zip::method_store, data.size(), nullptr, 0)
+        && _rwriter.write(data.data(), data.size())
+        && _rwriter.endFile(zip::crc32_update(0, data.data(), data.size()), data.size());
+}
+
+// aliases go last, with the CRC and digest of their target
+void add_manifest_aliases(ArchiveManifest& _rmanifest, const AliasIndex& _rindex)
+{
+    unordered_map<string, size_t> target_map;
+    for (size_t i = 0; i < _rmanifest.entries().size(); ++i) {
+        target_map.emplace(_rmanifest.entries()[i].name_, i);
+    }
+    for (const auto& member : _rindex.members()) {
+        const auto&          target = _rmanifest.entries()[target_map[member.target_]];
+        ArchiveManifestEntry entry;
+        entry.name_   = member.name_;
+        entry.size_   = member.size_;
+        entry.mtime_  = member.mtime_;
+        entry.crc_    = target.crc_;
+        entry.digest_ = target.digest_;
+        entry.meta_   = member.meta_;
+        _rmanifest.add(std::move(entry));
+    }
+}
+
+// last entry, right before the central directory
+bool write_manifest(zip::Writer& _rwriter, const ArchiveManifest& _rmanifest)
+{
+    const string data  = _rmanifest.store();
+    time_t       mtime = 0;
+    for (const auto& entry : _rmanifest.entries()) {
+        mtime = std::max(mtime, entry.mtime_);
+    }
+    return _rwriter.beginFile(ArchiveManifest::name(), mtime, zip::method_store, data.size(), nullptr, 0)
+        && _rwriter.write(data.data(), data.size())
+        && _rwriter.endFile(zip::crc32_update(0, data.data(), data.size()), data.size());
+}
+
+class CreatePipeline {
+    // slices compressed ahead of the writer, per worker
+    static constexpr size_t window_per_worker = 4;
+    // deflate dictionary primed from the previous slice, as pigz does
+    static constexpr size_t dictionary_size = 32 * 1024;
+
+    const ArchiveCreateOptions& roptions_;
+    vector<CreateEntry>&        rentries_;
+    vector<CreateJob>           jobs_;
+    unique_ptr<once_flag[]>     method_once_;
+    mutex                       mutex_;
+    condition_variable          worker_cnd_;
+    condition_variable          writer_cnd_;
+    size_t                      next_job_    = 0;
+    size_t                      written_job_ = 0;
+    size_t                      window_      = 0;
+    uint64_t                    pending_     = 0; // uncompressed bytes taken by workers, not yet written
+    bool                        stop_        = false;
+    bool                        keep_raw_    = false;
+    vector<thread>              workers_;
+
+public:
+    CreatePipeline(const ArchiveCreateOptions& _roptions, vector<CreateEntry>& _rentries)
+        : roptions_(_roptions)
+        , rentries_(_rentries)
+        , method_once_(new once_flag[_rentries.size()])
+    {
+        const uint64_t chunk_size = roptions_.chunk_size_ ? roptions_.chunk_size_ : 1024 * 1024;
+        for (size_t i = 0; i < rentries_.size(); ++i) {
+            auto& entry = rentries_[i];
+            if (entry.is_directory_ || entry.source_index_ >= 0) {
+                continue;
+            }
+            entry.job_begin_ = jobs_.size();
+            uint64_t offset  = 0;
+            do {
+                CreateJob job;
+                job.entry_index_ = i;
+                job.offset_      = offset;
+                job.size_        = static_cast<size_t>(std::min(chunk_size, entry.size_ - offset));
+                offset += job.size_;
+                job.last_ = offset == entry.size_;
+                jobs_.emplace_back(std::move(job));
+            } while (offset < entry.size_);
+            entry.job_end_ = jobs_.size();
+        }
+    }
+
+    ~CreatePipeline()
+    {
+        stop();
+    }
+
+    // with _pmanifest, every entry written is also added to it (solid blocks through _psolid_index)
+    bool run(
+        zip::Writer& _rwriter, zip_t* _psource_zip = nullptr,
+        vector<pair<string, string>>* _pfile_digests = nullptr, ArchiveManifest* _pmanifest = nullptr, const SolidIndex* _psolid_index = nullptr)
+    {
+        const size_t worker_count = std::max<size_t>(roptions_.worker_count_, 1);
+        Sha256Hasher file_hasher;
+
+        window_   = worker_count * window_per_worker;
+        keep_raw_ = _pfile_digests != nullptr;
+
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers_.emplace_back([this]() { workerRun(); });
+        }
+
+        for (auto& entry : rentries_) {
+            if (entry.is_directory_) {
+                if (!_rwriter.addDirectory(entry.name_, entry.mtime_)) {
+                    return false;
+                }
+                if (_pmanifest != nullptr) {
+                    _pmanifest->add(manifestEntry(entry, 0));
+                }
+                solid_log(logger, Info, "" << entry.name_);
+                continue;
+            }
+            if (entry.source_index_ >= 0) {
+                ObserverClock clock(roptions_.pobserver_);
+                if (!copyRaw(_rwriter, entry, _psource_zip)) {
+                    return false;
+                }
+                clock.entry(entry.name_, entry.size_, entry.source_compressed_size_, clock.lap(ArchivePhaseE::Write, entry.source_compressed_size_));
+                if (_pmanifest != nullptr) {
+                    _pmanifest->add(manifestEntry(entry, entry.source_crc_));
+                }
+                solid_log(logger, Info, "" << entry.name_ << " size = " << entry.size_ << " unchanged");
+                continue;
+            }
+
+            uint32_t                            crc             = 0;
+            uint64_t                            compressed_size = 0;
+            std::chrono::steady_clock::duration duration{};
+            for (size_t j = entry.job_begin_; j < entry.job_end_; ++j) {
+                auto& job = jobs_[j];
+                {
+                    unique_lock<mutex> lock(mutex_);
+                    writer_cnd_.wait(lock, [&job]() { return job.done_; });
+                }
+                // the first slice settles the entry method
+                if (j == entry.job_begin_ && (!job.ok_ || !_rwriter.beginFile(entry.name_, entry.mtime_, job.method_, entry.size_, entry.meta_.data(), entry.meta_.size()))) {
+                    return false;
+                }
+                ObserverClock clock(roptions_.pobserver_);
+                if (!job.ok_ || !_rwriter.write(job.data_.data(), job.data_.size())) {
+                    return false;
+                }
+                duration += job.duration_ + clock.lap(ArchivePhaseE::Write, job.data_.size());
+                compressed_size += job.data_.size();
+                crc = crc32_combine(crc, job.crc_, job.size_);
+                if (_pfile_digests != nullptr) {
+                    const string& raw = job.method_ == zip::method_store ? job.data_ : job.raw_;
+                    file_hasher.update(raw.data(), raw.size());
+                }
+                string().swap(job.data_);
+                string().swap(job.raw_);
+                {
+                    lock_guard<mutex> lock(mutex_);
+                    ++written_job_;
+                    pending_ -= job.size_;
+                }
+                worker_cnd_.notify_all();
+            }
+            if (!_rwriter.endFile(crc, entry.size_)) {
+                return false;
+            }
+            ObserverClock(roptions_.pobserver_).entry(entry.name_, entry.size_, compressed_size, duration);
+            if (_pfile_digests != nullptr) {
+                _pfile_digests->emplace_back(entry.name_, file_hasher.digest());
+            }
+            if (_pmanifest != nullptr) {
+                uint32_t solid_block = 0;
+                if (!entry.solid_members_.empty() && SolidIndex::isBlockName(entry.name_, solid_block)) {
+                    _pmanifest->addSolidBlock(*_psolid_index, solid_block);
+                } else {
+                    _pmanifest->add(manifestEntry(entry, crc));
+                    if (_pfile_digests != nullptr) {
+                        _pmanifest->entries().back().digest_ = _pfile_digests->back().second;
+                    }
+                }
+            }
+            solid_log(logger, Info, "" << entry.name_ << " size = " << entry.size_ << (entry.method_ == zip::method_store ? " stored" : ""));
+        }
+        return true;
+    }
+
+private:
+    static ArchiveManifestEntry manifestEntry(const CreateEntry& _rentry, const uint32_t _crc)
+    {
+        ArchiveManifestEntry entry;
+        entry.name_  = _rentry.name_;
+        entry.size_  = _rentry.size_;
+        entry.mtime_ = _rentry.mtime_;
+        entry.crc_   = _crc;
+        entry.meta_  = _rentry.meta_;
+        return entry;
+    }
+
+    bool copyRaw(zip::Writer& _rwriter, const CreateEntry& _rentry, zip_t* _psource_zip)
+    {
+        ZipFilePtrT zf_ptr(zip_fopen_index(_psource_zip, _rentry.source_index_, ZIP_FL_COMPRESSED));
+        if (!zf_ptr || !_rwriter.beginFile(_rentry.name_, _rentry.mtime_, _rentry.method_, _rentry.size_, _rentry.meta_.data(), _rentry.meta_.size())) {
+            return false;
+        }
+        constexpr size_t bufcp = 1024 * 64;
+        char             buf[bufcp];
+        uint64_t         copied = 0;
+        while (true) {
+            const auto v = zip_fread(zf_ptr.get(), buf, bufcp);
+            if (v < 0) {
+                solid_log(logger, Error, "Reading " << _rentry.name_ << ": " << zip_file_strerror(zf_ptr.get()));
+                return false;
+            }
+            if (v == 0) {
+                break;
+            }
+            if (!_rwriter.write(buf, v)) {
+                return false;
+            }
+            copied += v;
+        }
+        return copied == _rentry.source_compressed_size_ && _rwriter.endFile(_rentry.source_crc_, _rentry.size_);
+    }
+
+    void stop()
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            stop_ = true;
+        }
+        worker_cnd_.notify_all();
+        for (auto& t : workers_) {
+            t.join();
+        }
+        workers_.clear();
+    }
+
+    // jobs are taken in order, so the one the writer waits for is never held back
+    bool canTake(const CreateJob& _rjob) const
+    {
+        if (next_job_ >= (written_job_ + window_)) {
+            return false;
+        }
+        return pending_ == 0 || roptions_.read_ahead_size_ == 0 || (pending_ + _rjob.size_) <= roptions_.read_ahead_size_;
+    }
+
+    void workerRun()
+    {
+        z_stream   zs{};
+        string     in_buf;
+        const bool init_ok = deflateInit2(&zs, roptions_.compression_level_, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+
+        if (!init_ok) {
+            solid_log(logger, Error, "deflateInit2 failed");
+        }
+
+        unique_lock<mutex> lock(mutex_);
+        while (true) {
+            worker_cnd_.wait(lock, [this]() { return stop_ || next_job_ >= jobs_.size() || canTake(jobs_[next_job_]); });
+            if (stop_ || next_job_ >= jobs_.size()) {
+                break;
+            }
+            auto& job = jobs_[next_job_++];
+            pending_ += job.size_;
+            lock.unlock();
+
+            const bool ok = init_ok && compress(zs, in_buf, job);
+
+            lock.lock();
+            job.ok_   = ok;
+            job.done_ = true;
+            writer_cnd_.notify_one();
+        }
+        lock.unlock();
+        if (init_ok) {
+            deflateEnd(&zs);
+        }
+    }
+
+    bool compress(z_stream& _rzs, string& _rin_buf, CreateJob& _rjob)
+    {
+        auto&      entry  = rentries_[_rjob.entry_index_];
+        const bool single = _rjob.offset_ == 0 && _rjob.last_;
+
+        // multi slice entries must agree on the method before any slice is compressed
+        call_once(method_once_[_rjob.entry_index_], [this, &entry, single]() {
+            // solid blocks have no path to test; a single slice block is still checked after deflate
+            if (entry.solid_members_.empty() && (single ? is_store_extension(entry.path_, roptions_) : should_store(entry.path_, roptions_))) {
+                entry.method_ = zip::method_store;
+            }
+        });
+
+        const bool   store    = entry.method_ == zip::method_store;
+        const size_t dict_len = store ? 0 : static_cast<size_t>(std::min<uint64_t>(_rjob.offset_, dictionary_size));
+
+        _rin_buf.resize(dict_len + _rjob.size_);
+
+        ObserverClock clock(roptions_.pobserver_);
+
+        if (!_rin_buf.empty() && !read_entry_data(entry, _rjob.offset_ - dict_len, &_rin_buf[0], _rin_buf.size())) {
+            solid_log(logger, Error, "Reading " << entry.name_ << " at " << _rjob.offset_ << " failed or file changed");
+            return false;
+        }
+        _rjob.duration_ = clock.lap(ArchivePhaseE::Read, _rin_buf.size());
+
+        auto* pin = reinterpret_cast<Bytef*>(&_rin_buf[0]);
+
+        _rjob.crc_ = zip::crc32_update(0, pin + dict_len, _rjob.size_);
+
+        if (store) {
+            _rjob.method_ = zip::method_store;
+            _rjob.data_.swap(_rin_buf);
+            _rjob.duration_ += clock.lap(ArchivePhaseE::Compress, _rjob.size_);
+            return true;
+        }
+
+        if (deflateReset(&_rzs) != Z_OK) {
+            return false;
+        }
+        if (dict_len != 0 && deflateSetDictionary(&_rzs, pin, static_cast<uInt>(dict_len)) != Z_OK) {
+            return false;
+        }
+
+        const int flush = _rjob.last_ ? Z_FINISH : Z_SYNC_FLUSH;
+        size_t    len   = 0;
+
+        _rjob.data_.resize(deflateBound(&_rzs, _rjob.size_) + 64);
+        _rzs.next_in  = pin + dict_len;
+        _rzs.avail_in = static_cast<uInt>(_rjob.size_);
+        while (true) {
+            _rzs.next_out  = reinterpret_cast<Bytef*>(&_rjob.data_[len]);
+            _rzs.avail_out = static_cast<uInt>(_rjob.data_.size() - len);
+
+            const int rv = deflate(&_rzs, flush);
+
+            len = _rjob.data_.size() - _rzs.avail_out;
+
+            if (rv == Z_STREAM_ERROR) {
+                return false;
+            }
+            if (rv == Z_STREAM_END || (flush == Z_SYNC_FLUSH && _rzs.avail_in == 0 && _rzs.avail_out != 0)) {
+                break;
+            }
+            if (_rzs.avail_out == 0) {
+                _rjob.data_.resize(_rjob.data_.size() * 2);
+            }
+        }
+        _rjob.data_.resize(len);
+
+        if (single && roptions_.sample_size_ != 0 && is_incompressible(_rjob.size_, len, roptions_)) {
+            // the whole file was the sample
+            _rjob.method_ = zip::method_store;
+            _rjob.data_.assign(_rin_buf, dict_len, _rjob.size_);
+            entry.method_ = zip::method_store;
+        } else if (keep_raw_) {
+            _rjob.raw_.assign(_rin_buf, dict_len, _rjob.size_);
+        }
+        _rjob.duration_ += clock.lap(ArchivePhaseE::Compress, _rjob.size_);
+        return true;
+    }
+};
+
+bool archive_write_entries(
+    vector<CreateEntry>& _rentries, const ArchiveCreateOptions& _options, const CreateFileMetaFunctionT& _meta_fnc,
+    ArchiveWriteFunctionT&& _write_fnc, zip_t* _psource_zip = nullptr, ArchiveCreateResult* _presult = nullptr)
+{
+    Sha256Hasher archive_hasher;
+
+    if (_presult != nullptr && _options.compute_sha_sum_) {
+        _write_fnc = [&archive_hasher, write_fnc = std::move(_write_fnc)](const char* _data, size_t _size) mutable {
+            archive_hasher.update(_data, _size);
+            return write_fnc(_data, _size);
+        };
+    }
+
+    zip::Writer     writer(std::move(_write_fnc));
+    SolidIndex      solid_index;
+    AliasIndex      alias_index;
+    ArchiveManifest manifest;
+
+    if (!archive_meta(_rentries, _meta_fnc) || (_options.deduplicate_ && !deduplicate(_rentries, alias_index))) {
         return false;
     }
+    if (_options.solid_file_size_ != 0) {
+        solid_pack(_rentries, _options, solid_index);
+        // the index goes first so that streaming extraction knows the members of every block
+        if (!solid_index.empty() && !write_solid_index(writer, solid_index, _rentries)) {
+            return false;
+        }
+    }
+    // before the targets, for the same reason
+    if (!alias_index.empty() && !write_alias_index(writer, alias_index)) {
+        return false;
+    }
+    {
+        auto* pfile_digests = _presult != nullptr && _options.compute_file_digests_ ? &_presult->file_digests_ : nullptr;
 
-    if (!_root.empty() && _root.back() != '/') {
-        _root += '/';
+        CreatePipeline pipeline(_options, _rentries);
+        if (!pipeline.run(writer, _psource_zip, pfile_digests, _options.write_manifest_ ? &manifest : nullptr, &solid_index)) {
+            return false;
+        }
     }
+    if (_options.write_manifest_) {
+        add_manifest_aliases(manifest, alias_index);
+        if (!write_manifest(writer, manifest)) {
+            return false;
+        }
+    }
+    if (!writer.finish()) {
+        return false;
+    }
+    if (_presult != nullptr && _options.compute_sha_sum_) {
+        _presult->sha_sum_ = archive_hasher.digest();
+    }
+    return true;
+}
 
-    solid_log(logger, Info, "Create archive: " << _zip_path << " from " << _root);
-    _runcompressed_size = 0;
+bool archive_write(
+    const std::string& _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options, const CreateFileMetaFunctionT& _meta_fnc,
+    ArchiveWriteFunctionT&& _write_fnc, ArchiveCreateResult* _presult = nullptr)
+{
+    vector<CreateEntry> entries;
 
-    if (!is_directory(_root)) {
-        solid_log(logger, Error, "Path: " << _root << " not a directory");
+    return archive_scan(_root, _runcompressed_size, entries, _options) && archive_write_entries(entries, _options, _meta_fnc, std::move(_write_fnc), nullptr, _presult);
+}
+
+// _write_fnc(ArchiveWriteFunctionT&&) writes the whole archive into _zip_path, which must not exist
+template <class WriteFnc>
+bool archive_write_file(const std::string& _zip_path, WriteFnc _write_fnc)
+{
+    using namespace boost::filesystem;
+
+    boost::system::error_code err;
+
+    if (exists(_zip_path, err)) {
+        solid_log(logger, Error, "Creating archive: " << _zip_path << " already exists");
+        return false;
+    }
+
+    std::ofstream ofs(_zip_path, std::ofstream::binary);
+    if (!ofs) {
+        solid_log(logger, Error, "Creating archive: cannot open " << _zip_path);
         return false;
     }
 
-    for (directory_entry& x : directory_iterator(_root)) {
-        auto p = x.path();
-        if (is_directory(p)) {
-            zip_add_dir(pzip, p, _root.size(), _runcompressed_size, _meta_fnc, meta_data);
+    bool ok = _write_fnc([&ofs](const char* _data, size_t _size) {
+        ofs.write(_data, _size);
+        return ofs.good();
+    });
+    ofs.close();
+    ok = ok && !ofs.fail();
+
+    if (!ok) {
+        solid_log(logger, Error, "Creating archive: " << _zip_path << " failed");
+        remove(_zip_path, err);
+    }
+    return ok;
+}
+
+bool archive_create_parallel(
+    const std::string& _zip_path, const std::string& _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options, const CreateFileMetaFunctionT& _meta_fnc, ArchiveCreateResult* _presult = nullptr)
+{
+    return archive_write_file(_zip_path, [&](ArchiveWriteFunctionT&& _write_fnc) {
+        return archive_write(_root, _runcompressed_size, _options, _meta_fnc, std::move(_write_fnc), _presult);
+    });
+}
+
+bool file_crc(const boost::filesystem::path& _path, uint32_t& _rcrc)
+{
+    boost::filesystem::ifstream ifs(_path, std::ios::binary);
+    constexpr size_t            bufcp = 1024 * 64;
+    char                        buf[bufcp];
+
+    _rcrc = 0;
+    while (ifs.read(buf, bufcp) || ifs.gcount() != 0) {
+        _rcrc = zip::crc32_update(_rcrc, buf, static_cast<size_t>(ifs.gcount()));
+    }
+    return ifs.eof();
+}
+
+// mark the entries whose content is unchanged since the previous archive
+size_t archive_match_previous(zip_t* _pzip, vector<CreateEntry>& _rentries, const ArchiveUpdateOptions& _options)
+{
+    size_t     count = 0;
+    zip_stat_t stat;
+    for (auto& entry : _rentries) {
+        if (entry.is_directory_) {
+            continue;
+        }
+        const zip_int64_t index = zip_name_locate(_pzip, entry.name_.c_str(), 0);
+        if (index < 0 || zip_stat_index(_pzip, index, 0, &stat) != 0) {
+            continue;
+        }
+        constexpr zip_uint64_t needed = ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_MTIME | ZIP_STAT_CRC | ZIP_STAT_COMP_METHOD;
+        if ((stat.valid & needed) != needed || stat.size != entry.size_ || ((stat.valid & ZIP_STAT_ENCRYPTION_METHOD) != 0 && stat.encryption_method != 0)) {
+            continue;
+        }
+        // compare at zip (MS-DOS) time resolution
+        if (zip::dos_date_time(stat.mtime) != zip::dos_date_time(entry.mtime_)) {
+            continue;
+        }
+        uint32_t crc;
+        if (_options.check_crc_ && (!file_crc(entry.path_, crc) || crc != stat.crc)) {
+            continue;
+        }
+        entry.source_index_           = index;
+        entry.source_crc_             = stat.crc;
+        entry.source_compressed_size_ = stat.comp_size;
+        entry.method_                 = stat.comp_method;
+        ++count;
+    }
+    return count;
+}
+
+//-----------------------------------------------------------------------------
+// Parallel extraction
+//-----------------------------------------------------------------------------
+
+bool zip_read_entry(zip_t* _pzip, const zip_uint64_t _index, const zip_stat_t& _rstat, char* _buf, const size_t _bufcp, const FileWriteFunctionT& _file_write_function)
+{
+    ZipFilePtrT zf_ptr(zip_fopen_index(_pzip, _index, 0));
+    if (!zf_ptr) {
+        return false;
+    }
+    uint64_t fsz = 0;
+    do {
+        auto v = zip_fread(zf_ptr.get(), _buf, _bufcp);
+        if (v > 0) {
+            if (!_file_write_function(_buf, v)) {
+                return false;
+            }
+            fsz += v;
+        } else if (v < 0) {
+            solid_log(logger, Error, "Reading " << _rstat.name << ": " << zip_file_strerror(zf_ptr.get()));
+            return false;
         } else {
-            zip_add_file(pzip, p, _root.size(), _runcompressed_size, _meta_fnc, meta_data);
+            break;
+        }
+    } while (true);
+    return fsz == _rstat.size;
+}
+
+// Nothing is extracted from an archive with a name that would land outside the root.
+bool archive_check_names(zip_t* _pzip)
+{
+    zip_stat_t    stat;
+    const int64_t num_entries = zip_get_num_entries(_pzip, 0);
+    for (int64_t i = 0; i < num_entries; ++i) {
+        if (zip_stat_index(_pzip, i, 0, &stat) == 0 && !zip::is_safe_name(stat.name)) {
+            solid_log(logger, Error, "Unsafe entry name: " << stat.name);
+            return false;
         }
     }
-    zip_close(pzip);
     return true;
 }
 
-bool do_archive_extract(
+// Reads the solid and alias indexes (if any) and decides which entries are taken, see
+// EntrySelection. _rtaken gets one flag per entry; it stays empty when the filter takes everything.
+bool archive_select(zip_t* _pzip, SolidIndex& _rsolid_index, AliasIndex& _ralias_index, EntrySelection& _rselection, vector<bool>& _rtaken)
+{
+    if (_rselection.all()) {
+        return true;
+    }
+    zip_stat_t    stat;
+    const int64_t num_entries = zip_get_num_entries(_pzip, 0);
+    for (int64_t i = 0; i < num_entries; ++i) {
+        if (zip_stat_index(_pzip, i, 0, &stat) != 0) {
+            continue;
+        }
+        char buf[1024];
+        if (SolidIndex::isIndexName(stat.name) && !zip_read_entry(_pzip, i, stat, buf, sizeof(buf), _rsolid_index.indexWriter(stat.size))) {
+            return false;
+        }
+        if (AliasIndex::isName(stat.name) && !zip_read_entry(_pzip, i, stat, buf, sizeof(buf), _ralias_index.indexWriter(stat.size))) {
+            return false;
+        }
+    }
+    _rselection.addSolid(_rsolid_index);
+    _rselection.addAliases(_ralias_index);
+    _rtaken.resize(num_entries);
+    for (int64_t i = 0; i < num_entries; ++i) {
+        uint32_t solid_block = 0;
+        if (zip_stat_index(_pzip, i, 0, &stat) != 0) {
+            continue;
+        }
+        const size_t name_len = strlen(stat.name);
+        if (name_len == 0 || stat.name[name_len - 1] == '/' || SolidIndex::isIndexName(stat.name) || SolidIndex::isBlockName(stat.name, solid_block) || ArchiveManifest::isName(stat.name) || AliasIndex::isName(stat.name)) {
+            continue;
+        }
+        _rtaken[i] = _rselection.addFile(stat.name, stat.size);
+    }
+    return true;
+}
+
+bool archive_extract_serial(
     const std::string& _zip_path, const std::string& _root, uint64_t& _runcompressed_size,
-    OnCreateDirectoryFunctionT& _on_create_dir_function,
-    CreateWriteFunctionT&       _create_file_writer_function)
+    const ArchiveExtractOptions& _options,
+    OnCreateDirectoryFunctionT&  _on_create_dir_function,
+    CreateWriteFunctionT&        _create_file_writer_function)
 {
     using namespace boost::filesystem;
 
-    int                       err;
-    zip_t*                    pzip = zip_open(_zip_path.c_str(), ZIP_RDONLY, &err);
+    ZipPtrT zip_ptr = zip_open_read(_zip_path);
+    if (!zip_ptr) {
+        return false;
+    }
+
+    zip_t*                    pzip = zip_ptr.get();
     zip_stat_t                stat;
     constexpr size_t          bufcp = 1024 * 64;
     char                      buf[bufcp];
     boost::system::error_code error;
+    SolidIndex                solid_index;
+    AliasIndex                alias_index;
+    EntrySelection            selection(_options.filter_);
+    vector<bool>              taken;
     const int64_t             num_entries = zip_get_num_entries(pzip, 0);
+
+    if (!archive_check_names(pzip) || !archive_select(pzip, solid_index, alias_index, selection, taken)) {
+        return false;
+    }
+
     for (int64_t i = 0; i < num_entries; ++i) {
         if (zip_stat_index(pzip, i, 0, &stat) == 0) {
-            _runcompressed_size += stat.size;
-            size_t name_len = strlen(stat.name);
-            if (stat.name[name_len - 1] == '/') {
-
+            const size_t name_len = strlen(stat.name);
+            if (name_len != 0 && stat.name[name_len - 1] == '/') {
+                if (!selection.directory(stat.name)) {
+                    continue;
+                }
                 // folder
                 if (!create_directory(_root + '/' + stat.name, error) || !_on_create_dir_function(stat.name)) {
                     return false;
                 }
                 solid_log(logger, Info, "created directory: " << stat.name);
             } else {
-                zip_file* pzf = zip_fopen_index(pzip, i, 0);
+                // std::ofstream ofs(_root + '/' + stat.name);
+                ObserverClock                       clock(_options.pobserver_);
+                std::chrono::steady_clock::duration write_time{};
+                FileWriteFunctionT                  file_write_function;
+                uint32_t                            solid_block = 0;
+                if (ArchiveManifest::isName(stat.name)) {
+                    continue;
+                }
+                if (SolidIndex::isIndexName(stat.name)) {
+                    if (!selection.all()) {
+                        continue; // read by archive_select
+                    }
+                    file_write_function = solid_index.indexWriter(stat.size);
+                } else if (AliasIndex::isName(stat.name)) {
+                    if (!selection.all()) {
+                        continue; // read by archive_select
+                    }
+                    file_write_function = alias_index.indexWriter(stat.size);
+                } else if (SolidIndex::isBlockName(stat.name, solid_block)) {
+                    bool block_taken = false;
+                    _runcompressed_size += selection.blockSize(solid_index, solid_block, block_taken);
+                    if (!block_taken) {
+                        continue;
+                    }
+                    file_write_function = solid_index.blockWriter(solid_block, _create_file_writer_function, nullptr, selection.members());
+                } else {
+                    // the target of a taken alias is decompressed even when not taken itself
+                    const bool file_taken = taken.empty() || taken[i];
+                    if (!file_taken && !alias_index.taken(stat.name, selection.aliases())) {
+                        continue;
+                    }
+                    if (file_taken) {
+                        _runcompressed_size += stat.size;
 
-                if (pzf) {
-                    // std::ofstream ofs(_root + '/' + stat.name);
-                    uint16_t    meta_data_size = 0;
-                    const auto* meta_data      = zip_file_extra_field_get_by_id(pzip, i, meta_extra_field_id, 0, &meta_data_size, ZIP_FL_LOCAL);
+                        uint16_t    meta_data_size = 0;
+                        const auto* meta_data      = zip_file_extra_field_get_by_id(pzip, i, meta_extra_field_id, 0, &meta_data_size, ZIP_FL_LOCAL);
 
-                    FileWriteFunctionT file_write_function = _create_file_writer_function(stat.name, stat.size, meta_data, meta_data_size);
-                    if (!file_write_function) {
-                        return false;
+                        file_write_function = _create_file_writer_function(stat.name, stat.size, meta_data, meta_data_size);
+                    } else {
+                        file_write_function = [](const char*, size_t) { return true; };
+                    }
+                    if (file_write_function) {
+                        file_write_function = alias_index.fanOut(stat.name, std::move(file_write_function), _create_file_writer_function, nullptr, selection.aliases());
                     }
-                    uint64_t fsz = 0;
-                    do {
-                        auto v = zip_fread(pzf, buf, bufcp);
-                        if (v > 0) {
-                            if (!file_write_function(buf, v)) {
-                                return false;
-                            }
-                            fsz += v;
-                        } else {
-                            break;
+                }
+                if (!file_write_function) {
+                    return false;
+                }
+                file_write_function = clock.observeWrites(std::move(file_write_function), write_time);
+                ZipFilePtrT zf_ptr(zip_fopen_index(pzip, i, 0));
+                if (!zf_ptr) {
+                    return false;
+                }
+                uint64_t fsz = 0;
+                do {
+                    auto v = zip_fread(zf_ptr.get(), buf, bufcp);
+                    if (v > 0) {
+                        if (!file_write_function(buf, v)) {
+                            return false;
                         }
-                    } while (true);
-                    if (fsz != stat.size) {
+                        fsz += v;
+                    } else if (v < 0) {
+                        // libzip reports a CRC mismatch on the read that reaches the end of the entry
+                        solid_log(logger, Error, "Reading " << stat.name << ": " << zip_file_strerror(zf_ptr.get()));
                         return false;
+                    } else {
+                        break;
                     }
-                    solid_log(logger, Info, "Created file: " << stat.name);
-                } else {
+                } while (true);
+                if (fsz != stat.size) {
+                    solid_log(logger, Error, "Size mismatch for " << stat.name << ": " << fsz << " != " << stat.size);
                     return false;
                 }
+                clock.extracted(stat.name, stat.size, stat.comp_size, write_time);
+                solid_log(logger, Info, "Created file: " << stat.name);
             }
         }
     }
+    _runcompressed_size += selection.aliasSize(alias_index);
     return true;
 }
 
-bool archive_extract(const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size)
+bool archive_extract_parallel(
+    const std::string& _zip_path, const std::string& _root, uint64_t& _runcompressed_size,
+    const ArchiveExtractOptions& _options,
+    OnCreateDirectoryFunctionT&  _on_create_dir_function,
+    CreateWriteFunctionT&        _create_file_writer_function)
 {
-    auto create_dir_lambda   = [](const char*) { return true; };
-    auto create_write_lambda = [&_root](const char* _file_name, uint64_t /*_size*/, const uint8_t*, uint16_t) {
-        std::ofstream ofs(_root + '/' + _file_name, std::ofstream::binary);
-        if (ofs) {
-            auto lambda = [ofs = std::move(ofs)](const char* _buf, size_t _len) mutable {
-                ofs.write(_buf, _len);
-                return ofs.good();
-            };
-            return FileWriteFunctionT{std::move(lambda)};
-        } else {
-            return FileWriteFunctionT{};
+    using namespace boost::filesystem;
+
+    ZipPtrT zip_ptr = zip_open_read(_zip_path);
+    if (!zip_ptr) {
+        return false;
+    }
+
+    boost::system::error_code            error;
+    zip_stat_t                           stat;
+    vector<pair<uint64_t, zip_uint64_t>> files; // (size, index)
+    SolidIndex                           solid_index;
+    AliasIndex                           alias_index;
+    EntrySelection                       selection(_options.filter_);
+    vector<bool>                         taken;
+    const int64_t                        num_entries = zip_get_num_entries(zip_ptr.get(), 0);
+
+    if (!archive_check_names(zip_ptr.get()) || !archive_select(zip_ptr.get(), solid_index, alias_index, selection, taken)) {
+        return false;
+    }
+
+    // directories first, on the calling thread, in archive order
+    for (int64_t i = 0; i < num_entries; ++i) {
+        if (zip_stat_index(zip_ptr.get(), i, 0, &stat) == 0) {
+            const size_t name_len    = strlen(stat.name);
+            uint32_t     solid_block = 0;
+            if (ArchiveManifest::isName(stat.name)) {
+                continue;
+            }
+            if (SolidIndex::isIndexName(stat.name)) {
+                char buf[1024];
+                if (selection.all() && !zip_read_entry(zip_ptr.get(), i, stat, buf, sizeof(buf), solid_index.indexWriter(stat.size))) {
+                    return false;
+                }
+                continue;
+            }
+            if (AliasIndex::isName(stat.name)) {
+                char buf[1024];
+                if (selection.all() && !zip_read_entry(zip_ptr.get(), i, stat, buf, sizeof(buf), alias_index.indexWriter(stat.size))) {
+                    return false;
+                }
+                continue;
+            }
+            if (name_len != 0 && stat.name[name_len - 1] == '/') {
+                if (!selection.directory(stat.name)) {
+                    continue;
+                }
+                if (!create_directory(_root + '/' + stat.name, error) || !_on_create_dir_function(stat.name)) {
+                    return false;
+                }
+                solid_log(logger, Info, "created directory: " << stat.name);
+            } else if (SolidIndex::isBlockName(stat.name, solid_block)) {
+                // the whole index is known by now: it is written first
+                bool block_taken = false;
+                _runcompressed_size += selection.blockSize(solid_index, solid_block, block_taken);
+                if (block_taken) {
+                    files.emplace_back(stat.size, i);
+                }
+            } else if (taken.empty() || taken[i]) {
+                _runcompressed_size += stat.size;
+                files.emplace_back(stat.size, i);
+            } else if (alias_index.taken(stat.name, selection.aliases())) {
+                files.emplace_back(stat.size, i);
+            }
+        }
+    }
+    _runcompressed_size += selection.aliasSize(alias_index);
+    zip_ptr.reset();
+
+    // biggest files first so the tail of the extraction is made of small entries
+    std::stable_sort(files.begin(), files.end(), [](const auto& _a, const auto& _b) { return _a.first > _b.first; });
+
+    const size_t   worker_count = std::min(_options.worker_count_, std::max<size_t>(files.size(), 1));
+    atomic<size_t> next_file{0};
+    atomic<bool>   failed{false};
+    mutex          create_mutex;
+
+    auto worker_lambda = [&]() {
+        ZipPtrT worker_zip_ptr = zip_open_read(_zip_path);
+        if (!worker_zip_ptr) {
+            failed = true;
+            return;
+        }
+        constexpr size_t        bufcp = 1024 * 64;
+        std::unique_ptr<char[]> buf(new char[bufcp]);
+        zip_stat_t              entry_stat;
+
+        while (!failed) {
+            const size_t file_index = next_file.fetch_add(1);
+            if (file_index >= files.size()) {
+                break;
+            }
+            const auto index = files[file_index].second;
+            if (zip_stat_index(worker_zip_ptr.get(), index, 0, &entry_stat) != 0) {
+                failed = true;
+                break;
+            }
+            ObserverClock                       clock(_options.pobserver_);
+            std::chrono::steady_clock::duration write_time{};
+            FileWriteFunctionT                  file_write_function;
+            uint32_t                            solid_block = 0;
+            if (SolidIndex::isBlockName(entry_stat.name, solid_block)) {
+                file_write_function = solid_index.blockWriter(solid_block, _create_file_writer_function, &create_mutex, selection.members());
+            } else if (taken.empty() || taken[index]) {
+                uint16_t    meta_data_size = 0;
+                const auto* meta_data      = zip_file_extra_field_get_by_id(worker_zip_ptr.get(), index, meta_extra_field_id, 0, &meta_data_size, ZIP_FL_LOCAL);
+                {
+                    lock_guard<mutex> lock(create_mutex);
+                    file_write_function = _create_file_writer_function(entry_stat.name, entry_stat.size, meta_data, meta_data_size);
+                }
+                if (file_write_function) {
+                    file_write_function = alias_index.fanOut(entry_stat.name, std::move(file_write_function), _create_file_writer_function, &create_mutex, selection.aliases());
+                }
+            } else {
+                // only its aliases are taken
+                file_write_function = alias_index.fanOut(entry_stat.name, [](const char*, size_t) { return true; }, _create_file_writer_function, &create_mutex, selection.aliases());
+            }
+            file_write_function = clock.observeWrites(std::move(file_write_function), write_time);
+            if (!file_write_function || !zip_read_entry(worker_zip_ptr.get(), index, entry_stat, buf.get(), bufcp, file_write_function)) {
+                failed = true;
+                break;
+            }
+            clock.extracted(entry_stat.name, entry_stat.size, entry_stat.comp_size, write_time);
+            solid_log(logger, Info, "Created file: " << entry_stat.name);
         }
     };
-    return archive_extract(_path, _root, _runcompressed_size, create_dir_lambda, create_write_lambda);
+
+    vector<thread> workers;
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(worker_lambda);
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    return !failed;
+}
+} // namespace
+
+bool archive_create(
+    const std::string& _zip_path, std::string _root, uint64_t& _runcompressed_size,
+    CreateFileMetaFunctionT _meta_fnc)
+{
+    return archive_create(_zip_path, std::move(_root), _runcompressed_size, ArchiveCreateOptions{}, std::move(_meta_fnc));
+}
+
+bool archive_create(
+    const std::string& _zip_path, std::string _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options,
+    CreateFileMetaFunctionT     _meta_fnc)
+{
+    if (!_root.empty() && _root.back() != '/') {
+        _root += '/';
+    }
+
+    solid_log(logger, Info, "Create archive: " << _zip_path << " from " << _root << " using " << std::max<size_t>(_options.worker_count_, 1) << " workers");
+    _runcompressed_size = 0;
+
+    return archive_create_parallel(_zip_path, _root, _runcompressed_size, _options, _meta_fnc);
+}
+
+bool archive_create(
+    const std::string& _zip_path, std::string _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options, ArchiveCreateResult& _rresult,
+    CreateFileMetaFunctionT _meta_fnc)
+{
+    if (!_root.empty() && _root.back() != '/') {
+        _root += '/';
+    }
+
+    solid_log(logger, Info, "Create archive: " << _zip_path << " from " << _root << " using " << std::max<size_t>(_options.worker_count_, 1) << " workers, with digests");
+    _runcompressed_size = 0;
+    _rresult            = ArchiveCreateResult{};
+
+    return archive_create_parallel(_zip_path, _root, _runcompressed_size, _options, _meta_fnc, &_rresult);
+}
+
+bool archive_stream_create(
+    ArchiveWriteFunctionT _write_fnc, std::string _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options,
+    CreateFileMetaFunctionT     _meta_fnc)
+{
+    if (!_root.empty() && _root.back() != '/') {
+        _root += '/';
+    }
+
+    solid_log(logger, Info, "Stream archive from " << _root << " using " << _options.worker_count_ << " workers");
+    _runcompressed_size = 0;
+
+    return archive_write(_root, _runcompressed_size, _options, _meta_fnc, std::move(_write_fnc));
+}
+
+bool archive_stream_create(
+    std::ostream& _ros, std::string _root, uint64_t& _runcompressed_size,
+    const ArchiveCreateOptions& _options,
+    CreateFileMetaFunctionT     _meta_fnc)
+{
+    auto write_lambda = [&_ros](const char* _data, size_t _size) {
+        _ros.write(_data, _size);
+        return _ros.good();
+    };
+    return archive_stream_create(write_lambda, std::move(_root), _runcompressed_size, _options, std::move(_meta_fnc));
+}
+
+bool archive_update(
+    const std::string& _old_zip_path, std::string _root, const std::string& _new_zip_path, uint64_t& _runcompressed_size,
+    const ArchiveUpdateOptions& _options,
+    CreateFileMetaFunctionT     _meta_fnc)
+{
+    if (!_root.empty() && _root.back() != '/') {
+        _root += '/';
+    }
+
+    solid_log(logger, Info, "Update archive: " << _old_zip_path << " into " << _new_zip_path << " from " << _root);
+    _runcompressed_size = 0;
+
+    ZipPtrT             old_zip_ptr = zip_open_read(_old_zip_path);
+    vector<CreateEntry> entries;
+
+    if (!old_zip_ptr || !archive_scan(_root, _runcompressed_size, entries, _options.create_)) {
+        return false;
+    }
+
+    const size_t unchanged_count = archive_match_previous(old_zip_ptr.get(), entries, _options);
+
+    solid_log(logger, Info, "Update archive: " << unchanged_count << " of " << entries.size() << " entries copied without recompression");
+
+    return archive_write_file(_new_zip_path, [&](ArchiveWriteFunctionT&& _write_fnc) {
+        return archive_write_entries(entries, _options.create_, _meta_fnc, std::move(_write_fnc), old_zip_ptr.get());
+    });
+}
+
+bool do_archive_extract(
+    const std::string& _zip_path, const std::string& _root, uint64_t& _runcompressed_size,
+    OnCreateDirectoryFunctionT& _on_create_dir_function,
+    CreateWriteFunctionT&       _create_file_writer_function)
+{
+    return archive_extract_serial(_zip_path, _root, _runcompressed_size, ArchiveExtractOptions{}, _on_create_dir_function, _create_file_writer_function);
+}
+
+bool do_archive_extract(
+    const std::string& _zip_path, const std::string& _root, uint64_t& _runcompressed_size,
+    const ArchiveExtractOptions& _options,
+    OnCreateDirectoryFunctionT&  _on_create_dir_function,
+    CreateWriteFunctionT&        _create_file_writer_function)
+{
+    if (_options.worker_count_ == 0) {
+        return archive_extract_serial(_zip_path, _root, _runcompressed_size, _options, _on_create_dir_function, _create_file_writer_function);
+    }
+    return archive_extract_parallel(_zip_path, _root, _runcompressed_size, _options, _on_create_dir_function, _create_file_writer_function);
+}
+
+bool archive_extract(const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size)
+{
+    return archive_extract(_path, _root, _runcompressed_size, ArchiveExtractOptions{});
+}
+
+bool archive_extract(const std::string& _path, const std::string& _root, uint64_t& _runcompressed_size, const ArchiveExtractOptions& _options)
+{
+    return archive_extract_files(_path, _root, _runcompressed_size, _options);
 }
 
 } // namespace utility
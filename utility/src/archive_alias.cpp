@@ -0,0 +1,166 @@
+// myapps/common/utility/src/archive_alias.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "archive_alias.hpp"
+#include "solid/system/log.hpp"
+#include "zip_format.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive");
+
+constexpr const char* alias_index_name  = ".myapps_alias";
+constexpr uint32_t    alias_index_magic = 0x31494c41; // "ALI1"
+
+} // namespace
+
+bool AliasIndex::isName(std::string_view _name)
+{
+    return _name == alias_index_name;
+}
+
+std::string AliasIndex::name()
+{
+    return alias_index_name;
+}
+
+std::string AliasIndex::store() const
+{
+    string buf;
+    zip::store_u32(buf, alias_index_magic);
+    zip::store_u32(buf, static_cast<uint32_t>(members_.size()));
+    for (const auto& member : members_) {
+        zip::store_u16(buf, static_cast<uint16_t>(member.name_.size()));
+        buf += member.name_;
+        zip::store_u16(buf, static_cast<uint16_t>(member.target_.size()));
+        buf += member.target_;
+        zip::store_u64(buf, member.size_);
+        zip::store_u64(buf, static_cast<uint64_t>(member.mtime_));
+        zip::store_u16(buf, static_cast<uint16_t>(member.meta_.size()));
+        buf.append(reinterpret_cast<const char*>(member.meta_.data()), member.meta_.size());
+    }
+    return buf;
+}
+
+bool AliasIndex::load(const std::string& _data)
+{
+    zip::BufferReader reader(_data);
+
+    members_.clear();
+    if (reader.u32() != alias_index_magic) {
+        solid_log(logger, Error, "Invalid alias index");
+        return false;
+    }
+    const uint32_t count = reader.u32();
+    for (uint32_t i = 0; i < count && reader.ok(); ++i) {
+        AliasMember member;
+        member.name_   = reader.str(reader.u16());
+        member.target_ = reader.str(reader.u16());
+        member.size_   = reader.u64();
+        member.mtime_  = static_cast<time_t>(reader.u64());
+
+        const string meta = reader.str(reader.u16());
+        member.meta_.assign(meta.begin(), meta.end());
+        members_.emplace_back(std::move(member));
+    }
+    if (!reader.ok() || !std::is_sorted(members_.begin(), members_.end(), [](const AliasMember& _a, const AliasMember& _b) { return _a.target_ < _b.target_; })) {
+        solid_log(logger, Error, "Truncated or unsorted alias index");
+        members_.clear();
+        return false;
+    }
+    for (const auto& member : members_) {
+        if (!zip::is_safe_name(member.name_)) {
+            solid_log(logger, Error, "Unsafe alias name: " << member.name_);
+            members_.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+std::pair<size_t, size_t> AliasIndex::targetRange(std::string_view _target) const
+{
+    struct TargetLess {
+        bool operator()(const AliasMember& _a, std::string_view _b) const { return _a.target_ < _b; }
+        bool operator()(std::string_view _a, const AliasMember& _b) const { return _a < _b.target_; }
+    };
+    const auto range = std::equal_range(members_.begin(), members_.end(), _target, TargetLess());
+    return {range.first - members_.begin(), range.second - members_.begin()};
+}
+
+bool AliasIndex::taken(std::string_view _target, const std::vector<bool>* _ptaken) const
+{
+    const auto range = targetRange(_target);
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (_ptaken == nullptr || (*_ptaken)[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+FileWriteFunctionT AliasIndex::indexWriter(const uint64_t _size)
+{
+    return [this, data = string(), _size](const char* _data, size_t _len) mutable {
+        data.append(_data, _len);
+        if (data.size() > _size) {
+            return false;
+        }
+        return data.size() < _size || load(data);
+    };
+}
+
+FileWriteFunctionT AliasIndex::fanOut(std::string_view _target, FileWriteFunctionT&& _writer, CreateWriteFunctionT& _rcreate_fnc, std::mutex* _pmutex, const std::vector<bool>* _ptaken) const
+{
+    const auto range = targetRange(_target);
+    if (range.first == range.second) {
+        return std::move(_writer);
+    }
+
+    vector<FileWriteFunctionT> writers;
+    writers.emplace_back(std::move(_writer));
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (_ptaken != nullptr && !(*_ptaken)[i]) {
+            continue;
+        }
+        const auto&        member = members_[i];
+        unique_lock<mutex> lock;
+        if (_pmutex != nullptr) {
+            lock = unique_lock<mutex>(*_pmutex);
+        }
+        writers.emplace_back(_rcreate_fnc(member.name_.c_str(), member.size_, member.meta_.data(), static_cast<uint16_t>(member.meta_.size())));
+        if (!writers.back()) {
+            return FileWriteFunctionT{};
+        }
+        solid_log(logger, Info, "Created alias: " << member.name_ << " of " << member.target_);
+    }
+    return [writers = std::move(writers)](const char* _data, size_t _size) mutable {
+        for (auto& writer : writers) {
+            if (!writer(_data, _size)) {
+                return false;
+            }
+        }
+        return true;
+    };
+}
+
+} // namespace utility
+} // namespace myapps
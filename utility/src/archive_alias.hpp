@@ -0,0 +1,78 @@
+// myapps/common/utility/src/archive_alias.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+#include "myapps/common/utility/archive.hpp"
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+
+// Duplicate elimination (ArchiveCreateOptions::deduplicate_): a file with the same content as
+// an earlier one gets no entry of its own. The stored entry .myapps_alias, written before any
+// file entry, lists every such alias with the name of its target entry. The extraction
+// functions of this library write aliases along with their target; other zip tools do not
+// see them. Targets are always plain entries, never solid members.
+
+struct AliasMember {
+    std::string          name_;
+    std::string          target_;
+    uint64_t             size_  = 0;
+    time_t               mtime_ = 0;
+    std::vector<uint8_t> meta_;
+};
+
+class AliasIndex {
+    std::vector<AliasMember> members_; // by target, then in archive order
+
+public:
+    static bool        isName(std::string_view _name);
+    static std::string name();
+
+    bool empty() const { return members_.empty(); }
+
+    const std::vector<AliasMember>& members() const { return members_; }
+
+    // members must be added grouped by target, their names and metas within the uint16 sizes
+    // store writes them with
+    void add(AliasMember&& _rmember) { members_.emplace_back(std::move(_rmember)); }
+
+    std::string store() const;
+    bool        load(const std::string& _data);
+
+    // [first, last) aliases of _target
+    std::pair<size_t, size_t> targetRange(std::string_view _target) const;
+
+    // With _ptaken (by member index), whether any alias of _target is taken.
+    bool taken(std::string_view _target, const std::vector<bool>* _ptaken) const;
+
+    // Writer for the uncompressed content of the index entry, loaded once _size bytes arrived.
+    FileWriteFunctionT indexWriter(uint64_t _size);
+
+    // Writer for the uncompressed content of _target: feeds _writer and a writer per alias
+    // obtained from _rcreate_fnc (under *_pmutex when given), the taken ones with _ptaken.
+    // Returns _writer as is when _target has no aliases.
+    FileWriteFunctionT fanOut(std::string_view _target, FileWriteFunctionT&& _writer, CreateWriteFunctionT& _rcreate_fnc, std::mutex* _pmutex = nullptr, const std::vector<bool>* _ptaken = nullptr) const;
+};
+
+} // namespace utility
+} // namespace myapps
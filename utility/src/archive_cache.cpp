@@ -0,0 +1,487 @@
+// myapps/common/utility/src/archive_cache.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "myapps/common/utility/archive_reader.hpp"
+#include "archive_alias.hpp"
+#include "archive_list.hpp"
+#include "solid/system/log.hpp"
+#include "solid_block.hpp"
+#include <cstring>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive_reader");
+
+// arena block size; entries bigger than a quarter of a block get a block of their own
+constexpr size_t block_size = 1024 * 1024;
+// archives held open at once, whatever their indexes weigh, to bound the descriptors used
+constexpr size_t max_image_count = 1024;
+// hash or index node overhead per indexed name
+constexpr size_t node_size = 4 * sizeof(void*);
+
+struct Image;
+struct Block;
+using BlockPtrT = std::shared_ptr<Block>;
+
+struct Block {
+    unique_ptr<char[]>        data_;
+    size_t                    capacity_ = 0;
+    size_t                    size_     = 0;
+    Image*                    pimage_   = nullptr;
+    vector<uint64_t>          keys_; // Image::locations_ pointing here
+    list<BlockPtrT>::iterator lru_it_;
+    uint64_t                  last_use_ = 0;
+};
+
+struct Location {
+    BlockPtrT pblock_;
+    size_t    offset_ = 0;
+    size_t    size_   = 0;
+};
+
+// a location is charged to its image, so that even empty entries weigh on the budget
+constexpr size_t location_size = sizeof(Location) + sizeof(uint64_t) + node_size;
+
+struct Image {
+    string                             path_;
+    ArchiveReader                      reader_;
+    SolidIndex                         solid_index_;
+    AliasIndex                         alias_index_;
+    unordered_map<string_view, size_t> member_map_; // name to solid_index_ member
+    unordered_map<string_view, size_t> alias_map_; // name to alias_index_ member
+    unordered_map<uint64_t, Location>  locations_; // by location_key
+    once_flag                          list_once_;
+    ListIndex                          list_index_; // built on first list
+    BlockPtrT                          popen_block_; // small entries are packed here
+    uint64_t                           index_size_ = 0; // charged to the budget while cached
+    list<Image*>::iterator             lru_it_;
+    uint64_t                           last_use_ = 0;
+};
+
+// what an image holds besides its blocks: the central directory with its name index and
+// the solid and alias indexes with their name maps
+uint64_t index_size(const Image& _rimage)
+{
+    uint64_t size = sizeof(Image);
+    for (size_t i = 0; i < _rimage.reader_.entryCount(); ++i) {
+        size += sizeof(ArchiveEntry) + sizeof(uint32_t) + _rimage.reader_.entry(i).name_.size();
+    }
+    for (const auto& member : _rimage.solid_index_.members()) {
+        size += sizeof(SolidMember) + node_size + member.name_.size() + member.meta_.size();
+    }
+    for (const auto& member : _rimage.alias_index_.members()) {
+        size += sizeof(AliasMember) + node_size + member.name_.size() + member.target_.size() + member.meta_.size();
+    }
+    return size;
+}
+
+uint64_t location_key(const ArchiveEntry& _rentry, const Image& _rimage, const bool _raw)
+{
+    const uint64_t index = static_cast<uint64_t>(&_rentry - &_rimage.reader_.entry(0));
+    return index * 2 + (_raw ? 1 : 0);
+}
+
+ArchiveCacheData make_data(const BlockPtrT& _rpblock, const size_t _offset, const size_t _size)
+{
+    return ArchiveCacheData{shared_ptr<const char>(_rpblock, _rpblock->data_.get() + _offset), _size};
+}
+
+ArchiveCacheData make_data(string&& _rdata)
+{
+    auto pdata = make_shared<string>(std::move(_rdata));
+    return ArchiveCacheData{shared_ptr<const char>(pdata, pdata->data()), pdata->size()};
+}
+
+} // namespace
+
+struct ArchiveCache::Data {
+    const uint64_t                           capacity_;
+    mutable mutex                            mutex_;
+    unordered_map<string, shared_ptr<Image>> images_;
+    std::list<BlockPtrT>                     lru_; // most recently used first
+    std::list<Image*>                        image_lru_; // most recently used first
+    uint64_t                                 use_count_  = 0; // orders uses of blocks and images
+    uint64_t                                 size_       = 0;
+    uint64_t                                 hit_count_  = 0;
+    uint64_t                                 miss_count_ = 0;
+
+    Data(const uint64_t _capacity)
+        : capacity_(_capacity)
+    {
+    }
+
+    shared_ptr<Image> image(const string& _path)
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            const auto        it = images_.find(_path);
+            if (it != images_.end()) {
+                touch(*it->second);
+                return it->second;
+            }
+        }
+        // opened unlocked; a concurrent open of the same archive is dropped below
+        auto   pimage = make_shared<Image>();
+        string index_data;
+        pimage->path_ = _path;
+        if (!pimage->reader_.open(_path)) {
+            return nullptr;
+        }
+        if (pimage->reader_.find(SolidIndex::indexName()) != nullptr && (!pimage->reader_.readFile(SolidIndex::indexName(), index_data) || !pimage->solid_index_.load(index_data))) {
+            solid_log(logger, Error, "Invalid solid index in " << _path);
+            return nullptr;
+        }
+        const auto& members = pimage->solid_index_.members();
+        for (size_t i = 0; i < members.size(); ++i) {
+            pimage->member_map_.emplace(members[i].name_, i);
+        }
+        if (pimage->reader_.find(AliasIndex::name()) != nullptr && (!pimage->reader_.readFile(AliasIndex::name(), index_data) || !pimage->alias_index_.load(index_data))) {
+            solid_log(logger, Error, "Invalid alias index in " << _path);
+            return nullptr;
+        }
+        const auto& aliases = pimage->alias_index_.members();
+        for (size_t i = 0; i < aliases.size(); ++i) {
+            pimage->alias_map_.emplace(aliases[i].name_, i);
+        }
+        pimage->index_size_ = index_size(*pimage);
+
+        lock_guard<mutex> lock(mutex_);
+        const auto        it = images_.find(_path);
+        if (it != images_.end()) {
+            touch(*it->second);
+            return it->second;
+        }
+        // indexes bigger than the budget are used for this call only
+        if (pimage->index_size_ > capacity_) {
+            return pimage;
+        }
+        while (images_.size() >= max_image_count) {
+            drop(*image_lru_.back());
+        }
+        reserve(pimage->index_size_, nullptr);
+        size_ += pimage->index_size_;
+        pimage->lru_it_ = image_lru_.insert(image_lru_.begin(), pimage.get());
+        touch(*pimage);
+        return images_.emplace(_path, std::move(pimage)).first->second;
+    }
+
+    bool read(Image& _rimage, const ArchiveEntry& _rentry, const bool _raw, ArchiveCacheData& _rdata)
+    {
+        const uint64_t key = location_key(_rentry, _rimage, _raw);
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (find(_rimage, key, _rdata)) {
+                ++hit_count_;
+                return true;
+            }
+            ++miss_count_;
+        }
+
+        string     data;
+        const bool ok = _raw ? _rimage.reader_.readRaw(_rentry, data) : _rimage.reader_.readFile(_rentry, 0, numeric_limits<uint64_t>::max(), data);
+        if (!ok) {
+            return false;
+        }
+
+        lock_guard<mutex> lock(mutex_);
+        if (!find(_rimage, key, _rdata)) {
+            insert(_rimage, key, std::move(data), _rdata);
+        }
+        return true;
+    }
+
+    // charge the listing index of _rimage once it is built, if the image is still cached
+    void charge(Image& _rimage, const uint64_t _size)
+    {
+        lock_guard<mutex> lock(mutex_);
+        const auto        it = images_.find(_rimage.path_);
+        if (it == images_.end() || it->second.get() != &_rimage) {
+            return;
+        }
+        reserve(_size, &_rimage);
+        _rimage.index_size_ += _size;
+        size_ += _size;
+    }
+
+    // forget an image with its blocks; the archive is closed once the last user lets it go
+    void drop(Image& _rimage)
+    {
+        for (auto it = lru_.begin(); it != lru_.end();) {
+            Block& rblock = **it;
+            ++it;
+            if (rblock.pimage_ == &_rimage) {
+                release(rblock);
+            }
+        }
+        size_ -= _rimage.index_size_;
+        image_lru_.erase(_rimage.lru_it_);
+        images_.erase(images_.find(_rimage.path_));
+    }
+
+private:
+    bool find(Image& _rimage, const uint64_t _key, ArchiveCacheData& _rdata)
+    {
+        const auto it = _rimage.locations_.find(_key);
+        if (it == _rimage.locations_.end()) {
+            return false;
+        }
+        const Location& location = it->second;
+        touch(*location.pblock_);
+        _rdata = make_data(location.pblock_, location.offset_, location.size_);
+        return true;
+    }
+
+    void insert(Image& _rimage, const uint64_t _key, string&& _rdata_in, ArchiveCacheData& _rdata)
+    {
+        // a quarter at most, leaving room for the archive indexes
+        const size_t small_block_size = static_cast<size_t>(std::min<uint64_t>(block_size, capacity_ / 4));
+        const size_t size             = _rdata_in.size();
+        const auto   it               = images_.find(_rimage.path_);
+
+        // too big, or the archive was evicted meanwhile
+        if (size > capacity_ || it == images_.end() || it->second.get() != &_rimage) {
+            _rdata = make_data(std::move(_rdata_in));
+            return;
+        }
+
+        const bool   small    = size <= small_block_size / 4;
+        const bool   packed   = small && _rimage.popen_block_ && _rimage.popen_block_->capacity_ - _rimage.popen_block_->size_ >= size;
+        const size_t capacity = packed ? 0 : (small ? small_block_size : size); // of a new block
+        BlockPtrT    pblock   = packed ? _rimage.popen_block_ : nullptr;
+
+        reserve(capacity + location_size, &_rimage);
+        // the indexes of the archive leave too little of the budget, or the open block was evicted
+        if (size_ + capacity + location_size > capacity_ || (packed && _rimage.popen_block_ != pblock)) {
+            _rdata = make_data(std::move(_rdata_in));
+            return;
+        }
+        if (!packed) {
+            pblock = allocate(_rimage, capacity);
+            if (small) {
+                _rimage.popen_block_ = pblock;
+            }
+        }
+        _rimage.index_size_ += location_size;
+        size_ += location_size;
+
+        const size_t offset = pblock->size_;
+        if (size != 0) {
+            memcpy(pblock->data_.get() + offset, _rdata_in.data(), size);
+        }
+        pblock->size_ += size;
+        pblock->keys_.emplace_back(_key);
+        _rimage.locations_.emplace(_key, Location{pblock, offset, size});
+        touch(*pblock);
+        _rdata = make_data(pblock, offset, size);
+    }
+
+    // the room is reserved by the caller
+    BlockPtrT allocate(Image& _rimage, const size_t _capacity)
+    {
+        auto pblock       = make_shared<Block>();
+        pblock->data_     = unique_ptr<char[]>(new char[std::max<size_t>(_capacity, 1)]);
+        pblock->capacity_ = _capacity;
+        pblock->pimage_   = &_rimage;
+        pblock->lru_it_   = lru_.insert(lru_.begin(), pblock);
+        size_ += _capacity;
+        return pblock;
+    }
+
+    // data handed out keeps the block memory alive, it is only unaccounted here
+    void release(Block& _rblock)
+    {
+        Image& rimage = *_rblock.pimage_;
+        for (const auto key : _rblock.keys_) {
+            rimage.locations_.erase(key);
+        }
+        if (rimage.popen_block_.get() == &_rblock) {
+            rimage.popen_block_.reset();
+        }
+        const uint64_t locations_size = _rblock.keys_.size() * location_size;
+        rimage.index_size_ -= locations_size;
+        size_ -= _rblock.capacity_ + locations_size;
+        lru_.erase(_rblock.lru_it_);
+    }
+
+    // Evicts until _size more bytes fit the budget, least recently used first, be it a block
+    // or a whole image with its blocks. _pkeep, the image being served, keeps its indexes.
+    void reserve(const uint64_t _size, const Image* _pkeep)
+    {
+        while (size_ + _size > capacity_) {
+            Block* pblock = lru_.empty() ? nullptr : lru_.back().get();
+            Image* pimage = nullptr;
+            for (auto it = image_lru_.rbegin(); it != image_lru_.rend() && pimage == nullptr; ++it) {
+                if (*it != _pkeep) {
+                    pimage = *it;
+                }
+            }
+            if (pblock != nullptr && (pimage == nullptr || pblock->last_use_ < pimage->last_use_)) {
+                release(*pblock);
+            } else if (pimage != nullptr) {
+                drop(*pimage);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void touch(Image& _rimage)
+    {
+        image_lru_.splice(image_lru_.begin(), image_lru_, _rimage.lru_it_);
+        _rimage.last_use_ = ++use_count_;
+    }
+
+    // using a block is using its image too
+    void touch(Block& _rblock)
+    {
+        lru_.splice(lru_.begin(), lru_, _rblock.lru_it_);
+        touch(*_rblock.pimage_);
+        _rblock.last_use_ = use_count_;
+    }
+};
+
+ArchiveCache::ArchiveCache(const uint64_t _capacity)
+    : pimpl_(make_unique<Data>(_capacity))
+{
+}
+
+ArchiveCache::~ArchiveCache()
+{
+    clear();
+}
+
+bool ArchiveCache::readFile(const std::string& _path, std::string_view _name, ArchiveCacheData& _rdata)
+{
+    _rdata = ArchiveCacheData{};
+
+    const auto pimage = pimpl_->image(_path);
+    if (!pimage) {
+        return false;
+    }
+    // an alias shares the cached bytes of its target
+    const auto alias_it = pimage->alias_map_.find(_name);
+    if (alias_it != pimage->alias_map_.end()) {
+        _name = pimage->alias_index_.members()[alias_it->second].target_;
+    }
+    if (const ArchiveEntry* pentry = pimage->reader_.find(_name)) {
+        return pimpl_->read(*pimage, *pentry, false, _rdata);
+    }
+
+    // a solid member is a slice of its cached block
+    const auto it = pimage->member_map_.find(_name);
+    if (it == pimage->member_map_.end()) {
+        solid_log(logger, Error, "Entry not found: " << _name << " in " << _path);
+        return false;
+    }
+    const auto&         member = pimage->solid_index_.members()[it->second];
+    const ArchiveEntry* pblock = pimage->reader_.find(SolidIndex::blockName(member.block_));
+    ArchiveCacheData    block_data;
+    if (pblock == nullptr || !pimpl_->read(*pimage, *pblock, false, block_data) || member.offset_ + member.size_ > block_data.size_) {
+        solid_log(logger, Error, "Invalid solid block for " << _name << " in " << _path);
+        return false;
+    }
+    _rdata.pdata_ = shared_ptr<const char>(block_data.pdata_, block_data.pdata_.get() + member.offset_);
+    _rdata.size_  = static_cast<size_t>(member.size_);
+    return true;
+}
+
+bool ArchiveCache::readRaw(const std::string& _path, std::string_view _name, ArchiveCacheData& _rdata, ArchiveEntry& _rentry)
+{
+    _rdata = ArchiveCacheData{};
+
+    const auto pimage = pimpl_->image(_path);
+    if (!pimage) {
+        return false;
+    }
+    const ArchiveEntry* pentry = pimage->reader_.find(_name);
+    if (pentry == nullptr) {
+        solid_log(logger, Error, "Entry not found: " << _name << " in " << _path);
+        return false;
+    }
+    _rentry = *pentry;
+    return pimpl_->read(*pimage, *pentry, true, _rdata);
+}
+
+bool ArchiveCache::list(const std::string& _path, const std::string& _prefix, const bool _recursive, std::vector<ArchiveListEntry>& _rentries)
+{
+    _rentries.clear();
+    const auto pimage = pimpl_->image(_path);
+    if (!pimage) {
+        return false;
+    }
+    std::call_once(pimage->list_once_, [this, &pimage]() {
+        pimage->list_index_.load(pimage->reader_, pimage->solid_index_, pimage->alias_index_);
+        pimpl_->charge(*pimage, pimage->list_index_.memorySize());
+    });
+    return pimage->list_index_.list(_prefix, _recursive, _rentries);
+}
+
+void ArchiveCache::erase(const std::string& _path)
+{
+    lock_guard<mutex> lock(pimpl_->mutex_);
+    const auto        it = pimpl_->images_.find(_path);
+    if (it != pimpl_->images_.end()) {
+        pimpl_->drop(*it->second);
+    }
+}
+
+void ArchiveCache::clear()
+{
+    lock_guard<mutex> lock(pimpl_->mutex_);
+    while (!pimpl_->image_lru_.empty()) {
+        pimpl_->drop(*pimpl_->image_lru_.back());
+    }
+}
+
+uint64_t ArchiveCache::capacity() const
+{
+    return pimpl_->capacity_;
+}
+
+uint64_t ArchiveCache::size() const
+{
+    lock_guard<mutex> lock(pimpl_->mutex_);
+    return pimpl_->size_;
+}
+
+size_t ArchiveCache::imageCount() const
+{
+    lock_guard<mutex> lock(pimpl_->mutex_);
+    return pimpl_->images_.size();
+}
+
+uint64_t ArchiveCache::hitCount() const
+{
+    lock_guard<mutex> lock(pimpl_->mutex_);
+    return pimpl_->hit_count_;
+}
+
+uint64_t ArchiveCache::missCount() const
+{
+    lock_guard<mutex> lock(pimpl_->mutex_);
+    return pimpl_->miss_count_;
+}
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,862 @@
+// myapps/common/utility/src/archive_files.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "archive_alias.hpp"
+#include "archive_files.hpp"
+#include "archive_manifest.hpp"
+#include "archive_observer.hpp"
+#include "crc32.hpp"
+#include "entry_selection.hpp"
+#include "solid/system/log.hpp"
+#include "solid_block.hpp"
+#include "zip_file.hpp"
+#include "zip_format.hpp"
+#include "zip_reader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive");
+
+#ifdef _WIN32
+
+// The extracted tree, entries addressed by their full path.
+class OutputTree {
+    std::string root_;
+
+public:
+    bool open(const std::string& _root)
+    {
+        root_ = _root;
+        return boost::filesystem::is_directory(root_);
+    }
+
+    std::string path(const std::string& _name) const
+    {
+        return root_ + '/' + _name;
+    }
+
+    bool createDirectory(const std::string& _name, const bool _exist_ok)
+    {
+        boost::system::error_code error;
+        return boost::filesystem::create_directory(path(_name), error) || (!error && _exist_ok);
+    }
+
+    void created(const std::string& /*_name*/) {}
+};
+
+class OutputFile {
+    std::ofstream ofs_;
+
+public:
+    OutputFile(string& /*_rwrite_buf*/, const bool /*_sync*/) {}
+
+    bool open(OutputTree& _rtree, const std::string& _name, const uint64_t /*_size*/)
+    {
+        ofs_.open(boost::filesystem::path(_rtree.path(_name)).wstring(), std::ofstream::binary);
+        return ofs_.is_open();
+    }
+
+    bool write(const char* _data, const size_t _size)
+    {
+        ofs_.write(_data, _size);
+        return ofs_.good();
+    }
+
+    // no kernel side copy, everything goes through copy_buffered
+    uint64_t copy(const zip::File& /*_rsrc*/, const uint64_t /*_offset*/, const uint64_t /*_size*/)
+    {
+        return 0;
+    }
+
+    bool close()
+    {
+        ofs_.close();
+        return !ofs_.fail();
+    }
+};
+
+#else
+
+// The extracted tree. A directory used more than a couple of times (by name relative to the
+// root: "a/b/") gets a handle, kept in a bounded cache, so that its files and subdirectories are
+// created with openat/mkdirat against it instead of the kernel walking the whole path every
+// time; for a directory holding one or two entries the extra open and close do not pay off.
+class OutputTree {
+    struct Directory {
+        const int fd_;
+
+        explicit Directory(const int _fd)
+            : fd_(_fd)
+        {
+        }
+
+        ~Directory()
+        {
+            ::close(fd_);
+        }
+    };
+
+public:
+    using DirectoryPtrT = std::shared_ptr<const Directory>;
+
+private:
+    struct Use {
+        size_t        count_ = 0;
+        DirectoryPtrT pdir_;
+    };
+
+    // evicted handles stay open while in use
+    static constexpr size_t max_cached = 256;
+    static constexpr size_t open_after = 2; // uses
+
+    std::string                          root_;
+    DirectoryPtrT                        proot_;
+    mutex                                mutex_;
+    std::unordered_map<std::string, Use> cache_; // every directory but the root anything was created in
+    std::deque<std::string>              order_; // cache_ keys with a handle, oldest first
+
+public:
+    bool open(const std::string& _root)
+    {
+        root_        = _root;
+        const int fd = ::open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        proot_ = std::make_shared<const Directory>(fd);
+        return true;
+    }
+
+    std::string path(const std::string& _name) const
+    {
+        return root_ + '/' + _name;
+    }
+
+    // nullptr when it cannot be opened
+    DirectoryPtrT directory(const std::string& _name)
+    {
+        if (_name.empty()) {
+            return proot_;
+        }
+        {
+            lock_guard<mutex> lock(mutex_);
+            const auto        it = cache_.find(_name);
+            if (it != cache_.end() && it->second.pdir_) {
+                return it->second.pdir_;
+            }
+        }
+        const int fd = ::openat(proot_->fd_, _name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        return fd < 0 ? nullptr : std::make_shared<const Directory>(fd);
+    }
+
+    bool createDirectory(const std::string& _name, const bool _exist_ok)
+    {
+        DirectoryPtrT pparent;
+        const char*   name   = nullptr;
+        const int     dir_fd = at(_name, pparent, name);
+        if (::mkdirat(dir_fd, name, 0777) == 0) {
+            return true;
+        }
+        struct stat st;
+        return errno == EEXIST && _exist_ok && ::fstatat(dir_fd, name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+    }
+
+    int openFile(const std::string& _name)
+    {
+        DirectoryPtrT pparent;
+        const char*   name   = nullptr;
+        const int     dir_fd = at(_name, pparent, name);
+        return ::openat(dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+
+    // for _name created by path (aliases), not through createDirectory or openFile
+    void created(const std::string& _name)
+    {
+        const size_t len = parentLength(_name);
+        if (len != 0) {
+            lock_guard<mutex> lock(mutex_);
+            cache_[_name.substr(0, len)];
+        }
+    }
+
+    // see cache_
+    std::vector<std::string> directories()
+    {
+        lock_guard<mutex>        lock(mutex_);
+        std::vector<std::string> names;
+        names.reserve(cache_.size());
+        for (const auto& item : cache_) {
+            names.emplace_back(item.first);
+        }
+        return names;
+    }
+
+private:
+    // the length of the "a/b/" prefix of _name naming its parent, 0 for the root
+    static size_t parentLength(const std::string& _name)
+    {
+        const size_t end = !_name.empty() && _name.back() == '/' ? _name.size() - 1 : _name.size();
+        const size_t pos = end == 0 ? string::npos : _name.rfind('/', end - 1);
+        return pos == string::npos ? 0 : pos + 1;
+    }
+
+    // The directory to create _name (a file or a directory) at and its name there: the last
+    // component under the parent's handle, else the whole name under the root.
+    int at(const std::string& _name, DirectoryPtrT& _rpparent, const char*& _rname)
+    {
+        const size_t len = parentLength(_name);
+        _rpparent        = len == 0 ? proot_ : parent(_name.substr(0, len));
+        _rname           = _name.c_str() + (_rpparent ? len : 0);
+        return _rpparent ? _rpparent->fd_ : proot_->fd_;
+    }
+
+    // the handle of _name once used open_after times, nullptr before
+    DirectoryPtrT parent(const std::string& _name)
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto&             ruse = cache_[_name];
+        if (ruse.pdir_ || ++ruse.count_ <= open_after) {
+            return ruse.pdir_;
+        }
+        const int fd = ::openat(proot_->fd_, _name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        if (order_.size() == max_cached) {
+            cache_[order_.front()].pdir_.reset();
+            order_.pop_front();
+        }
+        ruse.pdir_ = std::make_shared<const Directory>(fd);
+        order_.emplace_back(_name);
+        return ruse.pdir_;
+    }
+};
+
+class OutputFile {
+    string& rwrite_buf_;
+    int     fd_   = -1;
+    bool    sync_ = false;
+
+public:
+    OutputFile(string& _rwrite_buf, const bool _sync)
+        : rwrite_buf_(_rwrite_buf)
+        , sync_(_sync)
+    {
+        rwrite_buf_.clear();
+    }
+
+    ~OutputFile()
+    {
+        close();
+    }
+
+    bool open(OutputTree& _rtree, const std::string& _name, const uint64_t _size)
+    {
+        fd_ = _rtree.openFile(_name);
+        if (fd_ < 0) {
+            return false;
+        }
+#ifdef __linux__
+        // one extent allocation instead of growing the file write by write;
+        // best effort - not every filesystem supports it
+        if (_size != 0) {
+            (void)::fallocate(fd_, 0, 0, static_cast<off_t>(_size));
+        }
+#endif
+        return true;
+    }
+
+    bool write(const char* _data, const size_t _size)
+    {
+        if (rwrite_buf_.size() + _size > rwrite_buf_.capacity()) {
+            if (!flush()) {
+                return false;
+            }
+            if (_size >= rwrite_buf_.capacity()) {
+                return writeAll(_data, _size);
+            }
+        }
+        rwrite_buf_.append(_data, _size);
+        return true;
+    }
+
+    // bytes copied kernel side, the caller copies the rest
+    uint64_t copy(const zip::File& _rsrc, const uint64_t _offset, const uint64_t _size)
+    {
+        uint64_t copied = 0;
+#ifdef __linux__
+        constexpr uint64_t max_step = 1024 * 1024 * 1024;
+
+        if (!flush()) {
+            return 0;
+        }
+        off_t offset = static_cast<off_t>(_offset);
+        // same filesystem: may be reflinked or done by the filesystem itself
+        while (copied < _size) {
+            const ssize_t rv = ::copy_file_range(_rsrc.nativeHandle(), &offset, fd_, nullptr, std::min(_size - copied, max_step), 0);
+            if (rv < 0 && errno == EINTR) {
+                continue;
+            }
+            if (rv <= 0) {
+                break;
+            }
+            copied += rv;
+        }
+        // cross filesystem on older kernels
+        while (copied < _size) {
+            const ssize_t rv = ::sendfile(fd_, _rsrc.nativeHandle(), &offset, std::min(_size - copied, max_step));
+            if (rv < 0 && errno == EINTR) {
+                continue;
+            }
+            if (rv <= 0) {
+                break;
+            }
+            copied += rv;
+        }
+#endif
+        return copied;
+    }
+
+    bool close()
+    {
+        if (fd_ < 0) {
+            return true;
+        }
+        bool ok = flush();
+        if (ok && sync_) {
+#ifdef __linux__
+            // only start the writeback, sync_tree waits for all files at once
+            ok = ::sync_file_range(fd_, 0, 0, SYNC_FILE_RANGE_WRITE) == 0;
+#else
+            ok = ::fsync(fd_) == 0;
+#endif
+        }
+        ok  = ::close(fd_) == 0 && ok;
+        fd_ = -1;
+        return ok;
+    }
+
+private:
+    bool flush()
+    {
+        const bool ok = writeAll(rwrite_buf_.data(), rwrite_buf_.size());
+        rwrite_buf_.clear();
+        return ok;
+    }
+
+    bool writeAll(const char* _data, size_t _size)
+    {
+        while (_size != 0) {
+            const ssize_t rv = ::write(fd_, _data, _size);
+            if (rv < 0 && errno == EINTR) {
+                continue;
+            }
+            if (rv <= 0) {
+                return false;
+            }
+            _data += rv;
+            _size -= rv;
+        }
+        return true;
+    }
+};
+
+#endif
+
+// with a null _pout the range is only read, for its CRC
+bool copy_buffered(OutputFile* _pout, const zip::File& _rsrc, uint64_t _offset, uint64_t _size, string& _rbuf, uint32_t& _rcrc)
+{
+    while (_size != 0) {
+        const size_t len = static_cast<size_t>(std::min<uint64_t>(_size, _rbuf.size()));
+        if (!_rsrc.read(_offset, &_rbuf[0], len) || (_pout != nullptr && !_pout->write(_rbuf.data(), len))) {
+            return false;
+        }
+        _rcrc = zip::crc32_update(_rcrc, _rbuf.data(), len);
+        _offset += len;
+        _size -= len;
+    }
+    return true;
+}
+
+bool extract_file(
+    const zip::File& _rzip_file, const ArchiveEntry& _rentry, OutputTree& _rtree, const ArchiveExtractOptions& _options,
+    string& _rread_buf, string& _rwrite_buf)
+{
+    uint64_t                            data_offset = 0;
+    OutputFile                          out(_rwrite_buf, _options.sync_);
+    ObserverClock                       clock(_options.pobserver_);
+    std::chrono::steady_clock::duration write_time{};
+
+    if (!zip::read_local_header(_rzip_file, _rentry, data_offset)) {
+        return false;
+    }
+    if (!out.open(_rtree, _rentry.name_, _rentry.size_)) {
+        solid_log(logger, Error, "Cannot create file: " << _rtree.path(_rentry.name_));
+        return false;
+    }
+    bool ok = false;
+    if (_options.zero_copy_ && _rentry.method_ == zip::method_store && _rentry.size_ == _rentry.compressed_size_) {
+        // the kernel copied range is read back from the archive for its CRC, now from the page cache
+        const uint64_t copied = out.copy(_rzip_file, data_offset, _rentry.size_);
+        uint32_t       crc    = 0;
+        ok                    = copy_buffered(nullptr, _rzip_file, data_offset, copied, _rread_buf, crc) && copy_buffered(&out, _rzip_file, data_offset + copied, _rentry.size_ - copied, _rread_buf, crc);
+        write_time            = clock.elapsed();
+        if (ok && crc != _rentry.crc_) {
+            solid_log(logger, Error, "CRC mismatch for " << _rentry.name_);
+            ok = false;
+        }
+    } else {
+        ok = zip::read_entry(_rzip_file, _rentry, data_offset, clock.observeWrites([&out](const char* _data, size_t _size) { return out.write(_data, _size); }, write_time));
+    }
+    ok = out.close() && ok;
+    if (ok) {
+        clock.extracted(_rentry.name_, _rentry.size_, _rentry.compressed_size_, write_time);
+    }
+    return ok;
+}
+
+// the block is small by construction: inflate it whole (checking its CRC), then split it
+bool extract_solid_block(
+    const zip::File& _rzip_file, const ArchiveEntry& _rentry, const uint32_t _block, const SolidIndex& _rindex,
+    const vector<bool>* _ptaken, OutputTree& _rtree, const ArchiveExtractOptions& _options, string& _rwrite_buf)
+{
+    string        data;
+    ObserverClock clock(_options.pobserver_);
+    if (!zip::read_entry(_rzip_file, _rentry, 0, _rentry.size_, data)) {
+        return false;
+    }
+    const auto decompress_time = clock.elapsed();
+    const auto range           = _rindex.blockRange(_block);
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (_ptaken != nullptr && !(*_ptaken)[i]) {
+            continue;
+        }
+        const auto& member = _rindex.members()[i];
+        OutputFile  out(_rwrite_buf, _options.sync_);
+        if (member.offset_ + member.size_ > data.size()) {
+            solid_log(logger, Error, "Solid member out of block: " << member.name_);
+            return false;
+        }
+        if (!out.open(_rtree, member.name_, member.size_)) {
+            solid_log(logger, Error, "Cannot create file: " << _rtree.path(member.name_));
+            return false;
+        }
+        const bool ok = out.write(data.data() + member.offset_, static_cast<size_t>(member.size_));
+        if (!out.close() || !ok) {
+            return false;
+        }
+    }
+    clock.extracted(_rentry.name_, _rentry.size_, _rentry.compressed_size_, clock.elapsed() - decompress_time);
+    return true;
+}
+
+// Aliases go once every file entry is extracted: hard linked or copied from the output of their
+// target or, when the target itself is not taken, from the first taken alias, extracted in its place.
+bool extract_aliases(
+    const zip::File& _rzip_file, const vector<ArchiveEntry>& _rentries, const vector<bool>& _rtaken, const AliasIndex& _rindex,
+    const vector<bool>* _ptaken, OutputTree& _rtree, const ArchiveExtractOptions& _options, string& _rread_buf, string& _rwrite_buf)
+{
+    boost::system::error_code error;
+    for (size_t i = 0; i < _rentries.size(); ++i) {
+        const auto& entry = _rentries[i];
+        const auto  range = _rindex.targetRange(entry.name_);
+        string      source;
+        if (range.first == range.second) {
+            continue;
+        }
+        if (_rtaken[i]) {
+            source = _rtree.path(entry.name_);
+        }
+        for (size_t j = range.first; j < range.second; ++j) {
+            if (_ptaken != nullptr && !(*_ptaken)[j]) {
+                continue;
+            }
+            const auto&  member = _rindex.members()[j];
+            const string path   = _rtree.path(member.name_);
+            boost::filesystem::remove(path, error);
+            if (source.empty()) {
+                ArchiveEntry alias_entry = entry;
+                alias_entry.name_        = member.name_;
+                if (!extract_file(_rzip_file, alias_entry, _rtree, _options, _rread_buf, _rwrite_buf)) {
+                    return false;
+                }
+                source = path;
+                continue;
+            }
+            if (_options.hardlink_aliases_) {
+                boost::filesystem::create_hard_link(source, path, error);
+            } else {
+                boost::filesystem::copy_file(source, path, error);
+            }
+            _rtree.created(member.name_);
+            if (error) {
+                solid_log(logger, Error, "Cannot create alias: " << path << " of " << source << ": " << error.message());
+                return false;
+            }
+            solid_log(logger, Info, "Created alias: " << member.name_);
+        }
+    }
+    return true;
+}
+
+// Makes the extracted tree durable: data of all files, then the entries of the directories
+// anything was created in - not the ones of the archive the filter left out.
+bool sync_tree(OutputTree& _rtree)
+{
+#ifdef _WIN32
+    (void)_rtree;
+    return true;
+#else
+    auto sync_dir = [&_rtree](const std::string& _name, const bool _whole_fs) {
+        const auto pdir = _rtree.directory(_name);
+        if (!pdir) {
+            return false;
+        }
+        bool ok = ::fsync(pdir->fd_) == 0;
+#ifdef __linux__
+        // flushes the data of every extracted file in one go
+        if (_whole_fs) {
+            ok = ::syncfs(pdir->fd_) == 0 && ok;
+        }
+#else
+        (void)_whole_fs;
+#endif
+        return ok;
+    };
+
+    bool ok = sync_dir(string(), true);
+    for (const auto& name : _rtree.directories()) {
+        ok = sync_dir(name, false) && ok;
+    }
+    return ok;
+#endif
+}
+
+// Sidecar of the entries already extracted: a header identifying the archive, then one
+// fixed size record (index, CRC, size) per entry whose output was written and verified.
+// Records are appended and flushed one by one, so a killed process loses at most the last one.
+class ExtractJournal {
+    static constexpr uint32_t magic       = 0x314a5845; // EXJ1
+    static constexpr size_t   header_size = 20;
+    static constexpr size_t   record_size = 16;
+
+    boost::filesystem::ofstream ofs_;
+    vector<bool>                done_;
+    mutex                       mutex_;
+
+public:
+    bool open(const std::string& _path, const uint64_t _zip_size, const vector<ArchiveEntry>& _rentries)
+    {
+        string header;
+        zip::store_u32(header, magic);
+        zip::store_u64(header, _zip_size);
+        zip::store_u32(header, static_cast<uint32_t>(_rentries.size()));
+        zip::store_u32(header, fingerprint(_rentries));
+
+        done_.assign(_rentries.size(), false);
+
+        string data;
+        {
+            boost::filesystem::ifstream ifs(_path, std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        }
+        size_t count = 0;
+        if (data.size() >= header_size && data.compare(0, header_size, header) == 0) {
+            // a torn last record is dropped
+            for (size_t pos = header_size; pos + record_size <= data.size(); pos += record_size) {
+                const uint32_t index = zip::load_u32(data.data() + pos);
+                if (index < _rentries.size() && _rentries[index].crc_ == zip::load_u32(data.data() + pos + 4) && _rentries[index].size_ == zip::load_u64(data.data() + pos + 8)) {
+                    done_[index] = true;
+                    ++count;
+                }
+            }
+            // rewrite only the valid records, then continue appending
+            ofs_.open(_path, std::ios::binary | std::ios::trunc);
+            ofs_.write(header.data(), header.size());
+            for (size_t i = 0; i < done_.size(); ++i) {
+                if (done_[i]) {
+                    writeRecord(static_cast<uint32_t>(i), _rentries[i]);
+                }
+            }
+        } else {
+            ofs_.open(_path, std::ios::binary | std::ios::trunc);
+            ofs_.write(header.data(), header.size());
+        }
+        ofs_.flush();
+        if (count != 0) {
+            solid_log(logger, Info, "Journal " << _path << ": " << count << " entries already extracted");
+        }
+        return ofs_.good();
+    }
+
+    bool done(const size_t _index) const
+    {
+        return !done_.empty() && done_[_index];
+    }
+
+    bool add(const uint32_t _index, const ArchiveEntry& _rentry)
+    {
+        if (!ofs_.is_open()) {
+            return true;
+        }
+        lock_guard<mutex> lock(mutex_);
+        writeRecord(_index, _rentry);
+        ofs_.flush();
+        return ofs_.good();
+    }
+
+private:
+    static uint32_t fingerprint(const vector<ArchiveEntry>& _rentries)
+    {
+        uint32_t crc = 0;
+        for (const auto& entry : _rentries) {
+            crc = zip::crc32_update(crc, entry.name_.data(), entry.name_.size());
+            crc = zip::crc32_update(crc, &entry.crc_, sizeof(entry.crc_));
+            crc = zip::crc32_update(crc, &entry.local_offset_, sizeof(entry.local_offset_));
+        }
+        return crc;
+    }
+
+    void writeRecord(const uint32_t _index, const ArchiveEntry& _rentry)
+    {
+        string record;
+        zip::store_u32(record, _index);
+        zip::store_u32(record, _rentry.crc_);
+        zip::store_u64(record, _rentry.size_);
+        ofs_.write(record.data(), record.size());
+    }
+};
+
+bool on_disk(const std::string& _path, const uint64_t _size)
+{
+    boost::system::error_code error;
+    const auto                size = boost::filesystem::file_size(_path, error);
+    return !error && size == _size;
+}
+
+// a journaled entry is skipped only while its output is still there with the right size
+bool already_extracted(
+    const ExtractJournal& _rjournal, const size_t _index, const ArchiveEntry& _rentry, const SolidIndex& _rsolid_index,
+    const vector<bool>* _ptaken, const std::string& _root)
+{
+    if (!_rjournal.done(_index)) {
+        return false;
+    }
+    uint32_t solid_block = 0;
+    if (SolidIndex::isBlockName(_rentry.name_, solid_block)) {
+        const auto range = _rsolid_index.blockRange(solid_block);
+        for (size_t i = range.first; i < range.second; ++i) {
+            const auto& member = _rsolid_index.members()[i];
+            if ((_ptaken == nullptr || (*_ptaken)[i]) && !on_disk(_root + '/' + member.name_, member.size_)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return on_disk(_root + '/' + _rentry.name_, _rentry.size_);
+}
+
+} // namespace
+
+bool archive_extract_files(
+    const std::string& _zip_path, const std::string& _root, uint64_t& _runcompressed_size,
+    const ArchiveExtractOptions& _options)
+{
+    using namespace boost::filesystem;
+
+    boost::system::error_code   error;
+    zip::File                   zip_file;
+    vector<ArchiveEntry>        entries;
+    vector<const ArchiveEntry*> files;
+    vector<bool>                taken;
+    SolidIndex                  solid_index;
+    AliasIndex                  alias_index;
+
+    if (!zip_file.open(_zip_path) || !zip::read_central_directory(zip_file, entries)) {
+        solid_log(logger, Error, "Cannot open archive: " << _zip_path);
+        return false;
+    }
+    // nothing is written when any name would land outside the root
+    for (const auto& entry : entries) {
+        if (!zip::is_safe_name(entry.name_)) {
+            solid_log(logger, Error, "Unsafe entry name: " << entry.name_);
+            return false;
+        }
+    }
+
+    EntrySelection selection(_options.filter_);
+
+    for (const auto& entry : entries) {
+        if (SolidIndex::isIndexName(entry.name_)) {
+            uint64_t data_offset = 0;
+            if (!zip::read_local_header(zip_file, entry, data_offset) || !zip::read_entry(zip_file, entry, data_offset, solid_index.indexWriter(entry.size_))) {
+                return false;
+            }
+            selection.addSolid(solid_index);
+        } else if (AliasIndex::isName(entry.name_)) {
+            uint64_t data_offset = 0;
+            if (!zip::read_local_header(zip_file, entry, data_offset) || !zip::read_entry(zip_file, entry, data_offset, alias_index.indexWriter(entry.size_))) {
+                return false;
+            }
+            selection.addAliases(alias_index);
+        }
+    }
+    _runcompressed_size += selection.aliasSize(alias_index);
+
+    // files before directories: a directory is taken when it holds a taken file
+    taken.resize(entries.size());
+    for (const auto& entry : entries) {
+        uint32_t solid_block = 0;
+        bool     entry_taken = false;
+        if (entry.isDirectory() || SolidIndex::isIndexName(entry.name_) || ArchiveManifest::isName(entry.name_) || AliasIndex::isName(entry.name_)) {
+            continue;
+        }
+        if (SolidIndex::isBlockName(entry.name_, solid_block)) {
+            _runcompressed_size += selection.blockSize(solid_index, solid_block, entry_taken);
+        } else if (selection.addFile(entry.name_, entry.size_)) {
+            _runcompressed_size += entry.size_;
+            entry_taken = true;
+        }
+        if (entry_taken) {
+            files.emplace_back(&entry);
+        }
+        taken[&entry - entries.data()] = entry_taken;
+    }
+
+    OutputTree tree;
+    if (!tree.open(_root)) {
+        solid_log(logger, Error, "Cannot open directory: " << _root);
+        return false;
+    }
+
+    // directories first, in archive order
+    for (const auto& entry : entries) {
+        if (!entry.isDirectory() || !selection.directory(entry.name_)) {
+            continue;
+        }
+        // a resumed extraction finds its directories already there
+        if (!tree.createDirectory(entry.name_, !_options.journal_path_.empty())) {
+            solid_log(logger, Error, "Cannot create directory: " << tree.path(entry.name_));
+            return false;
+        }
+        solid_log(logger, Info, "created directory: " << entry.name_);
+    }
+
+    ExtractJournal journal;
+    if (!_options.journal_path_.empty() && !journal.open(_options.journal_path_, zip_file.size(), entries)) {
+        solid_log(logger, Error, "Cannot open journal: " << _options.journal_path_);
+        return false;
+    }
+    const size_t all_file_count = files.size();
+    files.erase(std::remove_if(files.begin(), files.end(), [&](const ArchiveEntry* _pentry) {
+        return already_extracted(journal, _pentry - entries.data(), *_pentry, solid_index, selection.members(), _root);
+    }),
+        files.end());
+    if (files.size() != all_file_count) {
+        solid_log(logger, Info, "Resuming extraction: " << all_file_count - files.size() << " of " << all_file_count << " files skipped");
+    }
+
+    const size_t   worker_count = std::min(std::max<size_t>(_options.worker_count_, 1), std::max<size_t>(files.size(), 1));
+    atomic<size_t> next_file{0};
+    atomic<bool>   failed{false};
+
+    if (worker_count > 1) {
+        // biggest files first so the tail of the extraction is made of small entries
+        std::stable_sort(files.begin(), files.end(), [](const ArchiveEntry* _a, const ArchiveEntry* _b) { return _a->size_ > _b->size_; });
+    }
+
+    auto worker_lambda = [&]() {
+        string read_buf(zip::read_buffer_size, '\0');
+        string write_buf;
+        write_buf.reserve(_options.write_buffer_size_);
+        while (!failed) {
+            const size_t file_index = next_file.fetch_add(1);
+            if (file_index >= files.size()) {
+                break;
+            }
+            const ArchiveEntry& entry       = *files[file_index];
+            uint32_t            solid_block = 0;
+
+            const bool ok = SolidIndex::isBlockName(entry.name_, solid_block)
+                ? extract_solid_block(zip_file, entry, solid_block, solid_index, selection.members(), tree, _options, write_buf)
+                : extract_file(zip_file, entry, tree, _options, read_buf, write_buf);
+            if (!ok || !journal.add(static_cast<uint32_t>(&entry - entries.data()), entry)) {
+                failed = true;
+                break;
+            }
+            solid_log(logger, Info, "Created file: " << entry.name_);
+        }
+    };
+
+    if (worker_count == 1) {
+        worker_lambda();
+    } else {
+        vector<thread> workers;
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers.emplace_back(worker_lambda);
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+    if (failed) {
+        return false;
+    }
+    if (!alias_index.empty()) {
+        string read_buf(zip::read_buffer_size, '\0');
+        string write_buf;
+        write_buf.reserve(_options.write_buffer_size_);
+        if (!extract_aliases(zip_file, entries, taken, alias_index, selection.aliases(), tree, _options, read_buf, write_buf)) {
+            return false;
+        }
+    }
+    if (_options.sync_ && !sync_tree(tree)) {
+        solid_log(logger, Error, "Sync failed for: " << _root);
+        return false;
+    }
+    if (!_options.journal_path_.empty()) {
+        remove(_options.journal_path_, error);
+    }
+    return true;
+}
+
+} // namespace utility
+} // namespace myapps
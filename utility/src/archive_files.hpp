@@ -0,0 +1,35 @@
+// myapps/common/utility/src/archive_files.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "myapps/common/utility/archive.hpp"
+#include <string>
+
+namespace myapps {
+namespace utility {
+
+// Extraction straight into files under _root, behind the archive_extract overloads that
+// take no callbacks. Knowing that every entry ends up in a regular file, stored entries
+// can be moved kernel side from their data offset in the archive, and files are created
+// relative to cached handles of their directories.
+bool archive_extract_files(
+    const std::string& _zip_path, const std::string& _root, uint64_t& _runcompressed_size,
+    const ArchiveExtractOptions& _options);
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,164 @@
+// myapps/common/utility/src/archive_list.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "archive_list.hpp"
+#include "archive_alias.hpp"
+#include "archive_manifest.hpp"
+#include "solid/system/log.hpp"
+#include "solid_block.hpp"
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive");
+
+bool is_internal(const string& _name)
+{
+    uint32_t block = 0;
+    return SolidIndex::isIndexName(_name) || SolidIndex::isBlockName(_name, block) || AliasIndex::isName(_name) || ArchiveManifest::isName(_name);
+}
+
+string normalized_prefix(const string& _prefix)
+{
+    const size_t begin  = _prefix.find_first_not_of('/');
+    string       prefix = begin == string::npos ? string() : _prefix.substr(begin);
+    if (!prefix.empty() && prefix.back() != '/') {
+        prefix += '/';
+    }
+    return prefix;
+}
+} // namespace
+
+void ListIndex::load(const ArchiveReader& _rreader, const SolidIndex& _rsolid_index, const AliasIndex& _ralias_index, const std::string& _prefix)
+{
+    const string          prefix = normalized_prefix(_prefix);
+    unordered_set<string> directories;
+
+    auto under_prefix = [&prefix](const string& _name) { return _name.compare(0, prefix.size(), prefix) == 0; };
+
+    entries_.clear();
+    for (size_t i = 0; i < _rreader.entryCount(); ++i) {
+        const auto& entry = _rreader.entry(i);
+        if (under_prefix(entry.name_) && !is_internal(entry.name_)) {
+            entries_.push_back(ArchiveListEntry{entry.name_, entry.size_, entry.mtime_});
+            if (entry.isDirectory()) {
+                directories.emplace(entry.name_);
+            }
+        }
+    }
+    for (const auto& member : _rsolid_index.members()) {
+        if (under_prefix(member.name_)) {
+            entries_.push_back(ArchiveListEntry{member.name_, member.size_, member.mtime_});
+        }
+    }
+    for (const auto& member : _ralias_index.members()) {
+        if (under_prefix(member.name_)) {
+            entries_.push_back(ArchiveListEntry{member.name_, member.size_, member.mtime_});
+        }
+    }
+
+    // directories not stored, e.g. by archives from other tools; walking up from the parent
+    // stops at the first one known, its own parents are known as well
+    vector<ArchiveListEntry> implied;
+    for (const auto& entry : entries_) {
+        const string& name = entry.name_;
+        // the trailing '/' of a directory does not make a parent
+        for (size_t pos = name.size() < 2 ? string::npos : name.rfind('/', name.size() - 2); pos != string::npos && pos + 1 >= prefix.size(); pos = pos == 0 ? string::npos : name.rfind('/', pos - 1)) {
+            if (!directories.emplace(name, 0, pos + 1).second) {
+                break;
+            }
+            implied.push_back(ArchiveListEntry{name.substr(0, pos + 1)});
+        }
+    }
+    entries_.insert(entries_.end(), std::make_move_iterator(implied.begin()), std::make_move_iterator(implied.end()));
+    std::sort(entries_.begin(), entries_.end(), [](const ArchiveListEntry& _a, const ArchiveListEntry& _b) { return _a.name_ < _b.name_; });
+}
+
+bool ListIndex::list(const std::string& _prefix, const bool _recursive, std::vector<ArchiveListEntry>& _rentries) const
+{
+    const string prefix = normalized_prefix(_prefix);
+    auto         lower  = [this](const string& _name) {
+        return std::lower_bound(entries_.begin(), entries_.end(), _name, [](const ArchiveListEntry& _a, const string& _b) { return _a.name_ < _b; });
+    };
+
+    auto it = lower(prefix);
+    if (!prefix.empty()) {
+        if (it == entries_.end() || it->name_ != prefix) {
+            solid_log(logger, Error, "Not a directory in archive: " << prefix);
+            return false;
+        }
+        ++it;
+    }
+    while (it != entries_.end() && it->name_.compare(0, prefix.size(), prefix) == 0) {
+        _rentries.push_back(ArchiveListEntry{it->name_.substr(prefix.size()), it->size_, it->mtime_});
+        if (!_recursive && it->name_.back() == '/') {
+            // skip the subtree: names below "d/" sort before "d0"
+            string next = it->name_;
+            next.back() = '/' + 1;
+            it          = lower(next);
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+uint64_t ListIndex::memorySize() const
+{
+    uint64_t size = entries_.capacity() * sizeof(ArchiveListEntry);
+    for (const auto& entry : entries_) {
+        size += entry.name_.size();
+    }
+    return size;
+}
+
+bool archive_list(const std::string& _path, const std::string& _prefix, std::vector<ArchiveListEntry>& _rentries, const ArchiveListOptions& _options)
+{
+    if (_options.pcache_ != nullptr) {
+        return _options.pcache_->list(_path, _prefix, _options.recursive_, _rentries);
+    }
+
+    ArchiveReader reader;
+    SolidIndex    solid_index;
+    AliasIndex    alias_index;
+    ListIndex     list_index;
+    string        index_data;
+
+    _rentries.clear();
+    if (!reader.open(_path)) {
+        return false;
+    }
+    if (reader.find(SolidIndex::indexName()) != nullptr && (!reader.readFile(SolidIndex::indexName(), index_data) || !solid_index.load(index_data))) {
+        solid_log(logger, Error, "Invalid solid index in " << _path);
+        return false;
+    }
+    if (reader.find(AliasIndex::name()) != nullptr && (!reader.readFile(AliasIndex::name(), index_data) || !alias_index.load(index_data))) {
+        solid_log(logger, Error, "Invalid alias index in " << _path);
+        return false;
+    }
+    list_index.load(reader, solid_index, alias_index, _prefix);
+    return list_index.list(_prefix, _options.recursive_, _rentries);
+}
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,51 @@
+// myapps/common/utility/src/archive_list.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "myapps/common/utility/archive.hpp"
+#include "myapps/common/utility/archive_reader.hpp"
+#include <string>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+
+class AliasIndex;
+class SolidIndex;
+
+// What archive_list sees of an archive: file entries, solid members and aliases, plus the
+// directories - stored or only implied by the names below them - sorted by name, so that a
+// directory level or a subtree is found by binary search rather than by a scan of every entry.
+class ListIndex {
+    std::vector<ArchiveListEntry> entries_; // full names, directories end with '/'
+
+public:
+    // with _prefix, only what lies under it - enough for a single list call
+    void load(const ArchiveReader& _rreader, const SolidIndex& _rsolid_index, const AliasIndex& _ralias_index, const std::string& _prefix = std::string());
+
+    // Appends the entries under _prefix ("" for the root, "a/b" or "a/b/" below it) with names
+    // relative to it: its children only, or with _recursive its whole subtree.
+    // False when _prefix names no directory.
+    bool list(const std::string& _prefix, bool _recursive, std::vector<ArchiveListEntry>& _rentries) const;
+
+    // bytes held, as charged to an ArchiveCache budget
+    uint64_t memorySize() const;
+};
+
+} // namespace utility
+} // namespace myapps
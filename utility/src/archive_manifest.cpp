@@ -0,0 +1,149 @@
+// myapps/common/utility/src/archive_manifest.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "archive_manifest.hpp"
+#include "solid/system/log.hpp"
+#include "solid_block.hpp"
+#include "zip_format.hpp"
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive");
+
+constexpr const char* manifest_name  = ".myapps_manifest";
+constexpr uint32_t    manifest_magic = 0x31464d4d; // "MMF1"
+
+} // namespace
+
+bool ArchiveManifest::isName(std::string_view _name)
+{
+    return _name == manifest_name;
+}
+
+std::string ArchiveManifest::name()
+{
+    return manifest_name;
+}
+
+void ArchiveManifest::addSolidBlock(const SolidIndex& _rindex, const uint32_t _block)
+{
+    const auto range = _rindex.blockRange(_block);
+    for (size_t i = range.first; i < range.second; ++i) {
+        const auto&          member = _rindex.members()[i];
+        ArchiveManifestEntry entry;
+        entry.name_  = member.name_;
+        entry.size_  = member.size_;
+        entry.mtime_ = member.mtime_;
+        entry.meta_  = member.meta_;
+        entries_.emplace_back(std::move(entry));
+    }
+}
+
+std::string ArchiveManifest::store() const
+{
+    string buf;
+    zip::store_u32(buf, manifest_magic);
+    zip::store_u32(buf, static_cast<uint32_t>(entries_.size()));
+    for (const auto& entry : entries_) {
+        zip::store_u16(buf, static_cast<uint16_t>(entry.name_.size()));
+    }
+    for (const auto& entry : entries_) {
+        buf += entry.name_;
+    }
+    for (const auto& entry : entries_) {
+        zip::store_u64(buf, entry.size_);
+    }
+    for (const auto& entry : entries_) {
+        zip::store_u64(buf, static_cast<uint64_t>(entry.mtime_));
+    }
+    for (const auto& entry : entries_) {
+        zip::store_u32(buf, entry.crc_);
+    }
+    for (const auto& entry : entries_) {
+        buf += static_cast<char>(entry.digest_.size());
+    }
+    for (const auto& entry : entries_) {
+        buf += entry.digest_;
+    }
+    for (const auto& entry : entries_) {
+        zip::store_u16(buf, static_cast<uint16_t>(entry.meta_.size()));
+    }
+    for (const auto& entry : entries_) {
+        buf.append(reinterpret_cast<const char*>(entry.meta_.data()), entry.meta_.size());
+    }
+    return buf;
+}
+
+bool ArchiveManifest::load(const std::string& _data)
+{
+    zip::BufferReader reader(_data);
+
+    entries_.clear();
+    if (reader.u32() != manifest_magic) {
+        solid_log(logger, Error, "Invalid archive manifest");
+        return false;
+    }
+    const uint32_t count = reader.u32();
+    if (count > _data.size()) {
+        solid_log(logger, Error, "Truncated archive manifest");
+        return false;
+    }
+    entries_.resize(count);
+    for (auto& entry : entries_) {
+        entry.name_.resize(reader.u16());
+    }
+    for (auto& entry : entries_) {
+        entry.name_ = reader.str(entry.name_.size());
+    }
+    for (auto& entry : entries_) {
+        entry.size_ = reader.u64();
+    }
+    for (auto& entry : entries_) {
+        entry.mtime_ = static_cast<time_t>(reader.u64());
+    }
+    for (auto& entry : entries_) {
+        entry.crc_ = reader.u32();
+    }
+    for (auto& entry : entries_) {
+        entry.digest_.resize(reader.u8());
+    }
+    for (auto& entry : entries_) {
+        entry.digest_ = reader.str(entry.digest_.size());
+    }
+    for (auto& entry : entries_) {
+        entry.meta_.resize(reader.u16());
+    }
+    for (auto& entry : entries_) {
+        const char* p = reader.take(entry.meta_.size());
+        if (p != nullptr) {
+            entry.meta_.assign(p, p + entry.meta_.size());
+        }
+    }
+    if (!reader.ok()) {
+        solid_log(logger, Error, "Truncated archive manifest");
+        entries_.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,53 @@
+// myapps/common/utility/src/archive_manifest.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "myapps/common/utility/archive.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+
+class SolidIndex;
+
+// The manifest entry: every other entry of the archive in archive order, solid members in
+// place of their blocks, then the aliases of duplicate files. Stored column by column (all
+// names, then all sizes, ...) so that listing only some of the fields touches contiguous bytes.
+class ArchiveManifest {
+    std::vector<ArchiveManifestEntry> entries_;
+
+public:
+    static bool        isName(std::string_view _name);
+    static std::string name();
+
+    const std::vector<ArchiveManifestEntry>& entries() const { return entries_; }
+
+    std::vector<ArchiveManifestEntry>& entries() { return entries_; }
+
+    void add(ArchiveManifestEntry&& _rentry) { entries_.emplace_back(std::move(_rentry)); }
+
+    void addSolidBlock(const SolidIndex& _rindex, uint32_t _block);
+
+    std::string store() const;
+    bool        load(const std::string& _data);
+};
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,207 @@
+// myapps/common/utility/src/archive_observer.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "archive_observer.hpp"
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+
+using ClockT = std::chrono::steady_clock;
+
+const char* archive_phase_name(const ArchivePhaseE _phase)
+{
+    switch (_phase) {
+    case ArchivePhaseE::Scan:
+        return "scan";
+    case ArchivePhaseE::Read:
+        return "read";
+    case ArchivePhaseE::Compress:
+        return "compress";
+    case ArchivePhaseE::Decompress:
+        return "decompress";
+    case ArchivePhaseE::Write:
+        return "write";
+    }
+    return "unknown";
+}
+
+//-----------------------------------------------------------------------------
+// ObserverClock
+//-----------------------------------------------------------------------------
+
+ClockT::duration ObserverClock::lap(const ArchivePhaseE _phase, const uint64_t _bytes)
+{
+    if (!enabled()) {
+        return ClockT::duration::zero();
+    }
+    const auto now      = ClockT::now();
+    const auto duration = now - start_;
+    start_              = now;
+    phase(_phase, duration, _bytes);
+    return duration;
+}
+
+void ObserverClock::phase(const ArchivePhaseE _phase, const ClockT::duration _duration, const uint64_t _bytes) const
+{
+    if (enabled() && pobserver_->phase_fnc_) {
+        pobserver_->phase_fnc_(_phase, _duration, _bytes);
+    }
+}
+
+void ObserverClock::entry(const std::string& _name, const uint64_t _size, const uint64_t _compressed_size, const ClockT::duration _duration) const
+{
+    if (enabled() && pobserver_->entry_fnc_) {
+        ArchiveEntryEvent event;
+        event.name_            = _name.c_str();
+        event.size_            = _size;
+        event.compressed_size_ = _compressed_size;
+        event.duration_        = _duration;
+        pobserver_->entry_fnc_(event);
+    }
+}
+
+void ObserverClock::extracted(const std::string& _name, const uint64_t _size, const uint64_t _compressed_size, const ClockT::duration _write_time) const
+{
+    if (!enabled()) {
+        return;
+    }
+    const auto duration = elapsed();
+    phase(ArchivePhaseE::Decompress, duration - _write_time, _size);
+    phase(ArchivePhaseE::Write, _write_time, _size);
+    entry(_name, _size, _compressed_size, duration);
+}
+
+FileWriteFunctionT ObserverClock::observeWrites(FileWriteFunctionT&& _fnc, ClockT::duration& _rwrite_time) const
+{
+    if (!enabled() || !_fnc) {
+        return std::move(_fnc);
+    }
+    return [fnc = std::move(_fnc), &_rwrite_time](const char* _data, size_t _size) {
+        const auto start = ClockT::now();
+        const bool ok    = fnc(_data, _size);
+        _rwrite_time += ClockT::now() - start;
+        return ok;
+    };
+}
+
+//-----------------------------------------------------------------------------
+// ArchiveStatistics
+//-----------------------------------------------------------------------------
+
+struct ArchiveStatistics::Data {
+    struct Phase {
+        atomic<uint64_t> bytes_{0};
+        atomic<int64_t>  ticks_{0};
+    };
+
+    Phase              phases_[archive_phase_count];
+    atomic<uint64_t>   entry_count_{0};
+    atomic<uint64_t>   entry_size_{0};
+    ClockT::time_point start_ = ClockT::now();
+    ArchiveObserver    observer_;
+
+    Data()
+    {
+        observer_.phase_fnc_ = [this](const ArchivePhaseE _phase, const ClockT::duration _duration, const uint64_t _bytes) {
+            auto& phase = phases_[static_cast<size_t>(_phase)];
+            phase.bytes_ += _bytes;
+            phase.ticks_ += _duration.count();
+        };
+        observer_.entry_fnc_ = [this](const ArchiveEntryEvent& _event) {
+            ++entry_count_;
+            entry_size_ += _event.size_;
+        };
+    }
+};
+
+ArchiveStatistics::ArchiveStatistics()
+    : pimpl_(new Data)
+{
+}
+
+ArchiveStatistics::~ArchiveStatistics() = default;
+
+ArchiveObserver* ArchiveStatistics::observer()
+{
+    return &pimpl_->observer_;
+}
+
+void ArchiveStatistics::reset()
+{
+    for (auto& phase : pimpl_->phases_) {
+        phase.bytes_ = 0;
+        phase.ticks_ = 0;
+    }
+    pimpl_->entry_count_ = 0;
+    pimpl_->entry_size_  = 0;
+    pimpl_->start_       = ClockT::now();
+}
+
+uint64_t ArchiveStatistics::entryCount() const
+{
+    return pimpl_->entry_count_;
+}
+
+uint64_t ArchiveStatistics::entrySize() const
+{
+    return pimpl_->entry_size_;
+}
+
+uint64_t ArchiveStatistics::bytes(const ArchivePhaseE _phase) const
+{
+    return pimpl_->phases_[static_cast<size_t>(_phase)].bytes_;
+}
+
+std::chrono::steady_clock::duration ArchiveStatistics::time(const ArchivePhaseE _phase) const
+{
+    return ClockT::duration(pimpl_->phases_[static_cast<size_t>(_phase)].ticks_.load());
+}
+
+std::chrono::steady_clock::duration ArchiveStatistics::elapsed() const
+{
+    return ClockT::now() - pimpl_->start_;
+}
+
+std::string ArchiveStatistics::report() const
+{
+    constexpr double mb = 1024.0 * 1024.0;
+
+    auto seconds = [](const ClockT::duration _duration) { return std::chrono::duration<double>(_duration).count(); };
+    auto rate    = [](const uint64_t _bytes, const double _seconds) { return _seconds > 0 ? _bytes / mb / _seconds : 0.0; };
+
+    ostringstream oss;
+    const double  wall = seconds(elapsed());
+    oss << fixed << setprecision(3);
+    oss << entryCount() << " entries " << entrySize() / mb << " MB in " << wall << " s " << rate(entrySize(), wall) << " MB/s";
+    for (size_t i = 0; i < archive_phase_count; ++i) {
+        const auto   phase = static_cast<ArchivePhaseE>(i);
+        const double time  = seconds(this->time(phase));
+        if (time > 0 || bytes(phase) != 0) {
+            oss << "; " << archive_phase_name(phase) << ' ' << time << " s " << rate(bytes(phase), time) << " MB/s";
+        }
+    }
+    return oss.str();
+}
+
+} // namespace utility
+} // namespace myapps
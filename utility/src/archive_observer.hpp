@@ -0,0 +1,60 @@
+// myapps/common/utility/src/archive_observer.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "myapps/common/utility/archive.hpp"
+#include <chrono>
+#include <string>
+
+namespace myapps {
+namespace utility {
+
+// Feeds an optional ArchiveObserver; without one nothing is measured.
+class ObserverClock {
+    using ClockT    = std::chrono::steady_clock;
+    using DurationT = ClockT::duration;
+
+    ArchiveObserver*   pobserver_;
+    ClockT::time_point start_;
+
+public:
+    explicit ObserverClock(ArchiveObserver* _pobserver)
+        : pobserver_(_pobserver)
+        , start_(_pobserver != nullptr ? ClockT::now() : ClockT::time_point())
+    {
+    }
+
+    bool enabled() const { return pobserver_ != nullptr; }
+
+    DurationT elapsed() const { return enabled() ? ClockT::now() - start_ : DurationT::zero(); }
+
+    // reports the time since construction or the previous lap to _phase, then restarts
+    DurationT lap(ArchivePhaseE _phase, uint64_t _bytes);
+
+    void phase(ArchivePhaseE _phase, DurationT _duration, uint64_t _bytes) const;
+    void entry(const std::string& _name, uint64_t _size, uint64_t _compressed_size, DurationT _duration) const;
+
+    // an extracted entry: _write_time in Write (see observeWrites), the rest in Decompress
+    void extracted(const std::string& _name, uint64_t _size, uint64_t _compressed_size, DurationT _write_time) const;
+
+    // _fnc adding the time spent in it to _rwrite_time, or _fnc itself when not enabled
+    FileWriteFunctionT observeWrites(FileWriteFunctionT&& _fnc, DurationT& _rwrite_time) const;
+};
+
+} // namespace utility
+} // namespace myapps
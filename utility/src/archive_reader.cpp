@@ -0,0 +1,262 @@
+// myapps/common/utility/src/archive_reader.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "myapps/common/utility/archive_reader.hpp"
+#include "archive_manifest.hpp"
+#include "entry_selection.hpp"
+#include "solid/system/log.hpp"
+#include "zip_file.hpp"
+#include "zip_reader.hpp"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive_reader");
+
+bool read_manifest(const ArchiveReader& _rreader, ArchiveManifest& _rmanifest)
+{
+    string data;
+    if (!_rreader.readFile(ArchiveManifest::name(), data) || !_rmanifest.load(data)) {
+        solid_log(logger, Error, "Invalid archive manifest");
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+struct ArchiveReader::Data {
+    zip::File            file_;
+    vector<ArchiveEntry> entries_;
+    vector<uint32_t>     name_index_; // entries_ positions sorted by name
+};
+
+ArchiveReader::ArchiveReader()
+    : pimpl_(make_unique<Data>())
+{
+}
+
+ArchiveReader::~ArchiveReader() = default;
+
+ArchiveReader::ArchiveReader(ArchiveReader&&) noexcept            = default;
+ArchiveReader& ArchiveReader::operator=(ArchiveReader&&) noexcept = default;
+
+bool ArchiveReader::open(const std::string& _path)
+{
+    close();
+    if (!pimpl_->file_.open(_path)) {
+        solid_log(logger, Error, "Cannot open archive: " << _path);
+        return false;
+    }
+    if (!zip::read_central_directory(pimpl_->file_, pimpl_->entries_) || pimpl_->entries_.size() > numeric_limits<uint32_t>::max()) {
+        solid_log(logger, Error, "Invalid archive: " << _path);
+        close();
+        return false;
+    }
+
+    auto& entries = pimpl_->entries_;
+    auto& index   = pimpl_->name_index_;
+    index.resize(entries.size());
+    for (size_t i = 0; i < index.size(); ++i) {
+        index[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(index.begin(), index.end(), [&entries](const uint32_t _a, const uint32_t _b) {
+        return entries[_a].name_ < entries[_b].name_;
+    });
+    return true;
+}
+
+void ArchiveReader::close()
+{
+    pimpl_->file_.close();
+    pimpl_->entries_.clear();
+    pimpl_->name_index_.clear();
+}
+
+bool ArchiveReader::isOpen() const
+{
+    return pimpl_->file_.isOpen();
+}
+
+size_t ArchiveReader::entryCount() const
+{
+    return pimpl_->entries_.size();
+}
+
+const ArchiveEntry& ArchiveReader::entry(const size_t _index) const
+{
+    return pimpl_->entries_[_index];
+}
+
+const ArchiveEntry* ArchiveReader::find(std::string_view _name) const
+{
+    const auto& entries = pimpl_->entries_;
+    const auto& index   = pimpl_->name_index_;
+    const auto  it      = std::lower_bound(index.begin(), index.end(), _name, [&entries](const uint32_t _a, std::string_view _b) {
+        return entries[_a].name_ < _b;
+    });
+    if (it != index.end() && entries[*it].name_ == _name) {
+        return &entries[*it];
+    }
+    return nullptr;
+}
+
+bool ArchiveReader::readFile(const ArchiveEntry& _rentry, const uint64_t _offset, const uint64_t _len, std::string& _rdata) const
+{
+    return zip::read_entry(pimpl_->file_, _rentry, _offset, _len, _rdata);
+}
+
+bool ArchiveReader::readFile(std::string_view _name, const uint64_t _offset, const uint64_t _len, std::string& _rdata) const
+{
+    const ArchiveEntry* pentry = find(_name);
+    if (pentry == nullptr) {
+        solid_log(logger, Error, "Entry not found: " << _name);
+        _rdata.clear();
+        return false;
+    }
+    return readFile(*pentry, _offset, _len, _rdata);
+}
+
+bool ArchiveReader::readFile(std::string_view _name, std::string& _rdata) const
+{
+    return readFile(_name, 0, numeric_limits<uint64_t>::max(), _rdata);
+}
+
+bool ArchiveReader::readMeta(const ArchiveEntry& _rentry, std::vector<uint8_t>& _rmeta) const
+{
+    uint64_t data_offset = 0;
+    return zip::read_local_header(pimpl_->file_, _rentry, data_offset, &_rmeta);
+}
+
+bool ArchiveReader::dataOffset(const ArchiveEntry& _rentry, uint64_t& _roffset) const
+{
+    return zip::read_local_header(pimpl_->file_, _rentry, _roffset);
+}
+
+bool ArchiveReader::readRaw(const ArchiveEntry& _rentry, std::string& _rdata) const
+{
+    uint64_t data_offset = 0;
+    _rdata.clear();
+    if (!zip::read_local_header(pimpl_->file_, _rentry, data_offset)) {
+        return false;
+    }
+    _rdata.resize(_rentry.compressed_size_);
+    if (!_rdata.empty() && !pimpl_->file_.read(data_offset, &_rdata[0], _rdata.size())) {
+        _rdata.clear();
+        return false;
+    }
+    return true;
+}
+
+bool archive_read_manifest(const std::string& _path, std::vector<ArchiveManifestEntry>& _rentries)
+{
+    ArchiveReader   reader;
+    ArchiveManifest manifest;
+
+    _rentries.clear();
+    if (!reader.open(_path) || reader.find(ArchiveManifest::name()) == nullptr || !read_manifest(reader, manifest)) {
+        return false;
+    }
+    _rentries = std::move(manifest.entries());
+    return true;
+}
+
+bool archive_list(const std::string& _path, std::vector<ArchiveListEntry>& _rentries, const ArchiveEntryFilter& _filter)
+{
+    ArchiveReader  reader;
+    SolidIndex     solid_index;
+    EntrySelection selection(_filter);
+    string         index_data;
+    vector<bool>   taken;
+
+    _rentries.clear();
+    if (!reader.open(_path)) {
+        return false;
+    }
+    if (reader.find(ArchiveManifest::name()) != nullptr) {
+        ArchiveManifest manifest;
+        if (!read_manifest(reader, manifest)) {
+            return false;
+        }
+        // solid members are listed there already
+        const auto& entries      = manifest.entries();
+        auto        is_directory = [](const ArchiveManifestEntry& _rentry) { return !_rentry.name_.empty() && _rentry.name_.back() == '/'; };
+        taken.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (!is_directory(entries[i])) {
+                taken[i] = selection.addFile(entries[i].name_, entries[i].size_);
+            }
+        }
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (is_directory(entries[i]) ? selection.directory(entries[i].name_) : taken[i]) {
+                _rentries.push_back(ArchiveListEntry{entries[i].name_, entries[i].size_, entries[i].mtime_});
+            }
+        }
+        return true;
+    }
+    if (reader.find(SolidIndex::indexName()) != nullptr && (!reader.readFile(SolidIndex::indexName(), index_data) || !solid_index.load(index_data))) {
+        solid_log(logger, Error, "Invalid solid index in " << _path);
+        return false;
+    }
+    selection.addSolid(solid_index);
+
+    AliasIndex alias_index;
+    if (reader.find(AliasIndex::name()) != nullptr && (!reader.readFile(AliasIndex::name(), index_data) || !alias_index.load(index_data))) {
+        solid_log(logger, Error, "Invalid alias index in " << _path);
+        return false;
+    }
+    selection.addAliases(alias_index);
+
+    taken.resize(reader.entryCount());
+    for (size_t i = 0; i < reader.entryCount(); ++i) {
+        const auto& entry       = reader.entry(i);
+        uint32_t    solid_block = 0;
+        if (!entry.isDirectory() && !SolidIndex::isIndexName(entry.name_) && !SolidIndex::isBlockName(entry.name_, solid_block) && !ArchiveManifest::isName(entry.name_) && !AliasIndex::isName(entry.name_)) {
+            taken[i] = selection.addFile(entry.name_, entry.size_);
+        }
+    }
+
+    for (size_t i = 0; i < reader.entryCount(); ++i) {
+        const auto& entry       = reader.entry(i);
+        uint32_t    solid_block = 0;
+        if (SolidIndex::isBlockName(entry.name_, solid_block)) {
+            const auto range = solid_index.blockRange(solid_block);
+            for (size_t j = range.first; j < range.second; ++j) {
+                const auto& member = solid_index.members()[j];
+                if (selection.members() == nullptr || (*selection.members())[j]) {
+                    _rentries.push_back(ArchiveListEntry{member.name_, member.size_, member.mtime_});
+                }
+            }
+        } else if (entry.isDirectory() ? selection.directory(entry.name_) : taken[i]) {
+            _rentries.push_back(ArchiveListEntry{entry.name_, entry.size_, entry.mtime_});
+        }
+    }
+    for (size_t i = 0; i < alias_index.members().size(); ++i) {
+        const auto& member = alias_index.members()[i];
+        if (selection.aliases() == nullptr || (*selection.aliases())[i]) {
+            _rentries.push_back(ArchiveListEntry{member.name_, member.size_, member.mtime_});
+        }
+    }
+    return true;
+}
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,500 @@
+// myapps/common/utility/src/archive_stream.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "archive_alias.hpp"
+#include "archive_manifest.hpp"
+#include "crc32.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "solid/system/log.hpp"
+#include "solid_block.hpp"
+#include "zip_format.hpp"
+#include <boost/filesystem.hpp>
+#include <limits>
+#include <zlib.h>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive");
+
+enum struct StateE {
+    Signature,
+    LocalHeader,
+    LocalHeaderVariable,
+    StoredData,
+    DeflateData,
+    DataDescriptor,
+    Trailer,
+    Failed,
+};
+} // namespace
+
+struct ArchiveStreamExtractor::Data {
+    const string               root_;
+    OnCreateDirectoryFunctionT on_create_dir_function_;
+    CreateWriteFunctionT       create_file_writer_function_;
+    StateE                     state_ = StateE::Signature;
+    string                     buf_;
+    size_t                     need_              = 4;
+    uint64_t                   uncompressed_size_ = 0;
+    SolidIndex                 solid_index_;
+    AliasIndex                 alias_index_;
+    // current entry
+    string             name_;
+    uint16_t           flags_           = 0;
+    uint16_t           method_          = 0;
+    uint32_t           crc_             = 0;
+    uint64_t           compressed_size_ = 0;
+    uint64_t           size_            = 0;
+    bool               zip64_           = false;
+    bool               is_directory_    = false;
+    bool               is_internal_     = false; // solid or alias index, or manifest, not counted
+    uint64_t           remaining_       = 0;
+    uint64_t           written_         = 0;
+    uint32_t           computed_crc_    = 0;
+    FileWriteFunctionT file_write_function_;
+    z_stream           zs_{};
+    bool               zs_init_ = false;
+    unique_ptr<char[]> out_buf_;
+
+    static constexpr size_t out_capacity = 64 * 1024;
+
+    Data(const string& _root, OnCreateDirectoryFunctionT&& _on_create_dir_function, CreateWriteFunctionT&& _create_file_writer_function)
+        : root_(_root)
+        , on_create_dir_function_(std::move(_on_create_dir_function))
+        , create_file_writer_function_(std::move(_create_file_writer_function))
+    {
+    }
+
+    ~Data()
+    {
+        if (zs_init_) {
+            inflateEnd(&zs_);
+        }
+    }
+
+    bool fail(const char* _what)
+    {
+        solid_log(logger, Error, "Stream extract: " << _what << (name_.empty() ? "" : " entry: ") << name_);
+        state_ = StateE::Failed;
+        file_write_function_.reset();
+        return false;
+    }
+
+    // accumulate _need bytes of header into buf_
+    bool gather(const char*& _rdata, size_t& _rsize)
+    {
+        if (buf_.size() < need_) {
+            const size_t len = std::min(need_ - buf_.size(), _rsize);
+            buf_.append(_rdata, len);
+            _rdata += len;
+            _rsize -= len;
+        }
+        return buf_.size() >= need_;
+    }
+
+    bool push(const char* _data, size_t _size);
+
+private:
+    bool parseSignature();
+    bool parseLocalHeader();
+    bool parseLocalHeaderVariable();
+    bool consumeStored(const char*& _rdata, size_t& _rsize);
+    bool consumeDeflate(const char*& _rdata, size_t& _rsize);
+    bool parseDataDescriptor();
+    bool endData();
+    bool endEntry();
+    bool write(const char* _data, size_t _size);
+};
+
+bool ArchiveStreamExtractor::Data::push(const char* _data, size_t _size)
+{
+    while (_size != 0 || (state_ != StateE::Trailer && state_ != StateE::Failed && buf_.size() >= need_ && need_ != 0)) {
+        switch (state_) {
+        case StateE::Signature:
+            if (gather(_data, _size) && !parseSignature()) {
+                return false;
+            }
+            break;
+        case StateE::LocalHeader:
+            if (gather(_data, _size) && !parseLocalHeader()) {
+                return false;
+            }
+            break;
+        case StateE::LocalHeaderVariable:
+            if (gather(_data, _size) && !parseLocalHeaderVariable()) {
+                return false;
+            }
+            break;
+        case StateE::StoredData:
+            if (!consumeStored(_data, _size)) {
+                return false;
+            }
+            break;
+        case StateE::DeflateData:
+            if (!consumeDeflate(_data, _size)) {
+                return false;
+            }
+            break;
+        case StateE::DataDescriptor:
+            if (gather(_data, _size) && !parseDataDescriptor()) {
+                return false;
+            }
+            break;
+        case StateE::Trailer:
+            // central directory and end records - nothing left to extract
+            _size = 0;
+            break;
+        case StateE::Failed:
+            return false;
+        }
+    }
+    return state_ != StateE::Failed;
+}
+
+bool ArchiveStreamExtractor::Data::parseSignature()
+{
+    const uint32_t signature = zip::load_u32(buf_.data());
+    if (signature == zip::local_file_header_signature) {
+        state_ = StateE::LocalHeader;
+        need_  = zip::local_file_header_size;
+        return true;
+    }
+    if (signature == zip::central_file_header_signature || signature == zip::end_of_central_signature) {
+        state_ = StateE::Trailer;
+        need_  = 0;
+        buf_.clear();
+        return true;
+    }
+    return fail("unexpected signature");
+}
+
+bool ArchiveStreamExtractor::Data::parseLocalHeader()
+{
+    const char* p = buf_.data();
+
+    flags_           = zip::load_u16(p + 6);
+    method_          = zip::load_u16(p + 8);
+    crc_             = zip::load_u32(p + 14);
+    compressed_size_ = zip::load_u32(p + 18);
+    size_            = zip::load_u32(p + 22);
+    zip64_           = false;
+    name_.clear();
+
+    if ((flags_ & 1) != 0) {
+        return fail("encrypted entries are not supported");
+    }
+    if (method_ != zip::method_store && method_ != zip::method_deflate) {
+        return fail("unsupported compression method");
+    }
+    state_ = StateE::LocalHeaderVariable;
+    need_  = zip::local_file_header_size + zip::load_u16(p + 26) + zip::load_u16(p + 28);
+    return true;
+}
+
+bool ArchiveStreamExtractor::Data::parseLocalHeaderVariable()
+{
+    const char*    p         = buf_.data();
+    const uint16_t name_len  = zip::load_u16(p + 26);
+    const uint16_t extra_len = zip::load_u16(p + 28);
+    const char*    pextra    = p + zip::local_file_header_size + name_len;
+    const char*    pend      = pextra + extra_len;
+    const uint8_t* meta_data = nullptr;
+    uint16_t       meta_size = 0;
+    bool           has_hint  = false;
+    uint64_t       size_hint = 0;
+
+    name_.assign(p + zip::local_file_header_size, name_len);
+    if (!zip::is_safe_name(name_)) {
+        return fail("unsafe name");
+    }
+
+    while (pextra + 4 <= pend) {
+        const uint16_t id  = zip::load_u16(pextra);
+        const uint16_t len = zip::load_u16(pextra + 2);
+        const char*    pd  = pextra + 4;
+        if (pd + len > pend) {
+            return fail("invalid extra field");
+        }
+        if (id == zip::zip64_extra_field_id) {
+            const char* pz = pd;
+
+            zip64_ = true;
+            if (size_ == zip::max_u32 && pz + 8 <= pd + len) {
+                size_ = zip::load_u64(pz);
+                pz += 8;
+            }
+            if (compressed_size_ == zip::max_u32 && pz + 8 <= pd + len) {
+                compressed_size_ = zip::load_u64(pz);
+            }
+        } else if (id == zip::meta_extra_field_id) {
+            meta_data = reinterpret_cast<const uint8_t*>(pd);
+            meta_size = len;
+        } else if (id == zip::size_extra_field_id && len == 8) {
+            has_hint  = true;
+            size_hint = zip::load_u64(pd);
+        }
+        pextra = pd + len;
+    }
+
+    const bool deferred = (flags_ & zip::flag_data_descriptor) != 0;
+
+    if (deferred) {
+        size_ = size_hint;
+    }
+
+    is_directory_   = !name_.empty() && name_.back() == '/';
+    is_internal_    = SolidIndex::isIndexName(name_) || AliasIndex::isName(name_) || ArchiveManifest::isName(name_);
+    computed_crc_   = 0;
+    written_        = 0;
+
+    uint32_t solid_block = 0;
+
+    if (is_directory_) {
+        boost::system::error_code error;
+        if (!boost::filesystem::create_directory(root_ + '/' + name_, error) && error) {
+            return fail("create directory");
+        }
+        if (!on_create_dir_function_(name_.c_str())) {
+            return fail("create directory callback");
+        }
+        solid_log(logger, Info, "created directory: " << name_);
+    } else {
+        if (deferred && !has_hint && method_ == zip::method_store) {
+            return fail("stored entry of unknown size");
+        }
+        if (SolidIndex::isIndexName(name_)) {
+            file_write_function_ = solid_index_.indexWriter(size_);
+        } else if (AliasIndex::isName(name_)) {
+            file_write_function_ = alias_index_.indexWriter(size_);
+        } else if (ArchiveManifest::isName(name_)) {
+            file_write_function_ = [](const char*, size_t) { return true; };
+        } else if (SolidIndex::isBlockName(name_, solid_block)) {
+            file_write_function_ = solid_index_.blockWriter(solid_block, create_file_writer_function_);
+        } else {
+            // the alias index comes before any file entry
+            file_write_function_ = create_file_writer_function_(name_.c_str(), size_, meta_data, meta_size);
+            if (file_write_function_) {
+                file_write_function_ = alias_index_.fanOut(name_, std::move(file_write_function_), create_file_writer_function_);
+            }
+        }
+        if (!file_write_function_) {
+            return fail("create file writer");
+        }
+    }
+    buf_.clear();
+
+    if (method_ == zip::method_store) {
+        remaining_ = is_directory_ && deferred ? 0 : (deferred ? size_ : compressed_size_);
+        state_     = StateE::StoredData;
+        need_      = 0;
+        if (remaining_ == 0) {
+            return endData();
+        }
+        return true;
+    }
+
+    if (!zs_init_) {
+        if (inflateInit2(&zs_, -MAX_WBITS) != Z_OK) {
+            return fail("inflateInit2");
+        }
+        zs_init_ = true;
+        out_buf_.reset(new char[out_capacity]);
+    } else if (inflateReset(&zs_) != Z_OK) {
+        return fail("inflateReset");
+    }
+    remaining_ = deferred ? std::numeric_limits<uint64_t>::max() : compressed_size_;
+    state_     = StateE::DeflateData;
+    need_      = 0;
+    return true;
+}
+
+bool ArchiveStreamExtractor::Data::write(const char* _data, const size_t _size)
+{
+    computed_crc_ = zip::crc32_update(computed_crc_, _data, _size);
+    written_ += _size;
+    if (is_directory_) {
+        return _size == 0;
+    }
+    return file_write_function_(_data, _size);
+}
+
+bool ArchiveStreamExtractor::Data::consumeStored(const char*& _rdata, size_t& _rsize)
+{
+    const size_t len = static_cast<size_t>(std::min<uint64_t>(remaining_, _rsize));
+    if (!write(_rdata, len)) {
+        return fail("write");
+    }
+    _rdata += len;
+    _rsize -= len;
+    remaining_ -= len;
+    if (remaining_ == 0) {
+        return endData();
+    }
+    return true;
+}
+
+bool ArchiveStreamExtractor::Data::consumeDeflate(const char*& _rdata, size_t& _rsize)
+{
+    const size_t len = static_cast<size_t>(std::min<uint64_t>(remaining_, _rsize));
+
+    zs_.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(_rdata));
+    zs_.avail_in = static_cast<uInt>(len);
+
+    int rv;
+    do {
+        zs_.next_out  = reinterpret_cast<Bytef*>(out_buf_.get());
+        zs_.avail_out = static_cast<uInt>(out_capacity);
+
+        rv = inflate(&zs_, Z_NO_FLUSH);
+
+        if (rv != Z_OK && rv != Z_STREAM_END && rv != Z_BUF_ERROR) {
+            return fail("inflate");
+        }
+        const size_t produced = out_capacity - zs_.avail_out;
+        if (produced != 0 && !write(out_buf_.get(), produced)) {
+            return fail("write");
+        }
+    } while (rv != Z_STREAM_END && (zs_.avail_in != 0 || zs_.avail_out == 0));
+
+    const size_t consumed = len - zs_.avail_in;
+    _rdata += consumed;
+    _rsize -= consumed;
+    remaining_ -= consumed;
+
+    if (rv == Z_STREAM_END) {
+        if ((flags_ & zip::flag_data_descriptor) == 0 && remaining_ != 0) {
+            return fail("compressed size mismatch");
+        }
+        return endData();
+    }
+    if (remaining_ == 0) {
+        return fail("truncated deflate stream");
+    }
+    return true;
+}
+
+bool ArchiveStreamExtractor::Data::endData()
+{
+    if ((flags_ & zip::flag_data_descriptor) != 0) {
+        state_ = StateE::DataDescriptor;
+        // crc + two sizes, plus the optional signature which is checked once 4 bytes are in
+        need_ = 4;
+        return true;
+    }
+    return endEntry();
+}
+
+bool ArchiveStreamExtractor::Data::parseDataDescriptor()
+{
+    const size_t sizes_len = zip64_ ? 16 : 8;
+    const bool   has_sign  = zip::load_u32(buf_.data()) == zip::data_descriptor_signature;
+    const size_t full      = (has_sign ? 4 : 0) + 4 + sizes_len;
+
+    if (need_ < full) {
+        need_ = full;
+        return true;
+    }
+    const char* p = buf_.data() + (has_sign ? 4 : 0);
+    crc_          = zip::load_u32(p);
+    if (zip64_) {
+        compressed_size_ = zip::load_u64(p + 4);
+        size_            = zip::load_u64(p + 12);
+    } else {
+        compressed_size_ = zip::load_u32(p + 4);
+        size_            = zip::load_u32(p + 8);
+    }
+    buf_.clear();
+    return endEntry();
+}
+
+bool ArchiveStreamExtractor::Data::endEntry()
+{
+    if (written_ != size_) {
+        return fail("size mismatch");
+    }
+    if (!is_internal_) {
+        // with the copies written by its aliases
+        const auto range = alias_index_.targetRange(name_);
+        uncompressed_size_ += written_ * (1 + range.second - range.first);
+    }
+    if (!is_directory_ && computed_crc_ != crc_) {
+        return fail("crc mismatch");
+    }
+    if (!is_directory_) {
+        file_write_function_.reset();
+        solid_log(logger, Info, "Created file: " << name_);
+    }
+    name_.clear();
+    state_ = StateE::Signature;
+    need_  = 4;
+    return true;
+}
+
+ArchiveStreamExtractor::ArchiveStreamExtractor(
+    const std::string& _root, OnCreateDirectoryFunctionT&& _on_create_dir_function,
+    CreateWriteFunctionT&& _create_file_writer_function)
+    : pimpl_(new Data(_root, std::move(_on_create_dir_function), std::move(_create_file_writer_function)))
+{
+}
+
+ArchiveStreamExtractor::ArchiveStreamExtractor(const std::string& _root)
+    : ArchiveStreamExtractor(
+        _root,
+        [](const char*) { return true; },
+        [_root](const char* _file_name, uint64_t /*_size*/, const uint8_t*, uint16_t) {
+            std::ofstream ofs(_root + '/' + _file_name, std::ofstream::binary);
+            if (ofs) {
+                auto lambda = [ofs = std::move(ofs)](const char* _buf, size_t _len) mutable {
+                    ofs.write(_buf, _len);
+                    return ofs.good();
+                };
+                return FileWriteFunctionT{std::move(lambda)};
+            } else {
+                return FileWriteFunctionT{};
+            }
+        })
+{
+}
+
+ArchiveStreamExtractor::~ArchiveStreamExtractor() {}
+
+bool ArchiveStreamExtractor::push(const char* _data, const size_t _size)
+{
+    return pimpl_->push(_data, _size);
+}
+
+bool ArchiveStreamExtractor::done() const
+{
+    return pimpl_->state_ == StateE::Trailer;
+}
+
+bool ArchiveStreamExtractor::failed() const
+{
+    return pimpl_->state_ == StateE::Failed;
+}
+
+uint64_t ArchiveStreamExtractor::uncompressedSize() const
+{
+    return pimpl_->uncompressed_size_;
+}
+
+} // namespace utility
+} // namespace myapps
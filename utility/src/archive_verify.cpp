@@ -0,0 +1,279 @@
+// myapps/common/utility/src/archive_verify.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#include "archive_alias.hpp"
+#include "archive_manifest.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "solid/system/log.hpp"
+#include "solid_block.hpp"
+#include "zip_file.hpp"
+#include "zip_format.hpp"
+#include "zip_reader.hpp"
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive");
+
+bool verify_solid_block(const ArchiveEntry& _rentry, const uint32_t _block, const SolidIndex& _rsolid_index, const ArchiveVerifyOptions& _options, string& _rerror)
+{
+    const auto range  = _rsolid_index.blockRange(_block);
+    uint64_t   offset = 0;
+    for (size_t i = range.first; i < range.second; ++i) {
+        const auto& member = _rsolid_index.members()[i];
+        if (member.offset_ != offset) {
+            _rerror = "solid member " + member.name_ + " not at its offset";
+            return false;
+        }
+        if (_options.meta_fnc_ && !_options.meta_fnc_(member.name_, member.meta_)) {
+            _rerror = "meta of solid member " + member.name_ + " rejected";
+            return false;
+        }
+        offset += member.size_;
+    }
+    if (range.first == range.second || offset != _rentry.size_) {
+        _rerror = "solid block size differs from its members";
+        return false;
+    }
+    return true;
+}
+
+bool verify_entry(const zip::File& _rfile, const ArchiveEntry& _rentry, const SolidIndex& _rsolid_index, const ArchiveVerifyOptions& _options, vector<uint8_t>& _rmeta, string& _rerror)
+{
+    uint64_t data_offset = 0;
+    uint32_t block       = 0;
+
+    if (!zip::read_local_header(_rfile, _rentry, data_offset, &_rmeta, true)) {
+        _rerror = "invalid local header or extra fields";
+        return false;
+    }
+    if (_rentry.isDirectory()) {
+        if (_rentry.size_ != 0) {
+            _rerror = "directory with content";
+            return false;
+        }
+        return true;
+    }
+    if (SolidIndex::isBlockName(_rentry.name_, block)) {
+        if (!verify_solid_block(_rentry, block, _rsolid_index, _options, _rerror)) {
+            return false;
+        }
+    } else if (_options.meta_fnc_ && !SolidIndex::isIndexName(_rentry.name_) && !ArchiveManifest::isName(_rentry.name_) && !AliasIndex::isName(_rentry.name_) && !_options.meta_fnc_(_rentry.name_, _rmeta)) {
+        _rerror = "meta rejected";
+        return false;
+    }
+    if (!zip::read_entry(_rfile, _rentry, data_offset, [](const char*, size_t) { return true; })) {
+        _rerror = "corrupt data: inflate, size or CRC check failed";
+        return false;
+    }
+    return true;
+}
+
+// every alias must name a plain file entry of its size
+bool verify_aliases(const vector<ArchiveEntry>& _rentries, const AliasIndex& _ralias_index, const ArchiveVerifyOptions& _options, string& _rerror)
+{
+    unordered_map<string_view, const ArchiveEntry*> entry_map;
+    for (const auto& entry : _rentries) {
+        entry_map.emplace(entry.name_, &entry);
+    }
+    uint32_t block = 0;
+    for (const auto& member : _ralias_index.members()) {
+        const auto it = entry_map.find(member.target_);
+        if (it == entry_map.end() || it->second->isDirectory() || SolidIndex::isIndexName(member.target_) || SolidIndex::isBlockName(member.target_, block) || ArchiveManifest::isName(member.target_) || AliasIndex::isName(member.target_)) {
+            _rerror = "alias " + member.name_ + " without target";
+            return false;
+        }
+        if (it->second->size_ != member.size_) {
+            _rerror = "alias " + member.name_ + " differs in size from its target";
+            return false;
+        }
+        if (_options.meta_fnc_ && !_options.meta_fnc_(member.name_, member.meta_)) {
+            _rerror = "meta of alias " + member.name_ + " rejected";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool verify_manifest(const zip::File& _rfile, const ArchiveEntry& _rentry, const vector<ArchiveEntry>& _rentries, const SolidIndex& _rsolid_index, const AliasIndex& _ralias_index, string& _rerror)
+{
+    string          data;
+    ArchiveManifest manifest;
+    if (!zip::read_entry(_rfile, _rentry, 0, _rentry.size_, data) || !manifest.load(data)) {
+        _rerror = "invalid manifest";
+        return false;
+    }
+
+    unordered_map<string_view, const ArchiveEntry*> entry_map;
+    unordered_map<string_view, const SolidMember*>  member_map;
+    unordered_map<string_view, const AliasMember*>  alias_map;
+    uint32_t                                        block = 0;
+    for (const auto& entry : _rentries) {
+        if (!SolidIndex::isIndexName(entry.name_) && !SolidIndex::isBlockName(entry.name_, block) && !ArchiveManifest::isName(entry.name_) && !AliasIndex::isName(entry.name_)) {
+            entry_map.emplace(entry.name_, &entry);
+        }
+    }
+    for (const auto& member : _rsolid_index.members()) {
+        member_map.emplace(member.name_, &member);
+    }
+    for (const auto& alias : _ralias_index.members()) {
+        alias_map.emplace(alias.name_, &alias);
+    }
+    const size_t count = entry_map.size() + member_map.size() + alias_map.size();
+    if (manifest.entries().size() != count) {
+        _rerror = "manifest lists " + to_string(manifest.entries().size()) + " entries, the archive holds " + to_string(count);
+        return false;
+    }
+    for (const auto& item : manifest.entries()) {
+        const auto entry_it = entry_map.find(item.name_);
+        if (entry_it != entry_map.end()) {
+            if (entry_it->second->size_ != item.size_ || entry_it->second->crc_ != item.crc_) {
+                _rerror = "manifest disagrees on " + item.name_;
+                return false;
+            }
+            continue;
+        }
+        const auto alias_it = alias_map.find(item.name_);
+        if (alias_it != alias_map.end()) {
+            if (alias_it->second->size_ != item.size_) {
+                _rerror = "manifest disagrees on " + item.name_;
+                return false;
+            }
+            continue;
+        }
+        const auto member_it = member_map.find(item.name_);
+        if (member_it == member_map.end() || member_it->second->size_ != item.size_) {
+            _rerror = "manifest disagrees on " + item.name_;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool archive_verify(const std::string& _path, ArchiveVerifyResult& _rresult, const ArchiveVerifyOptions& _options)
+{
+    zip::File            zip_file;
+    vector<ArchiveEntry> entries;
+    SolidIndex           solid_index;
+    AliasIndex           alias_index;
+    string               error;
+
+    _rresult = ArchiveVerifyResult{};
+
+    auto fail = [&_path, &_rresult](const string& _name, const string& _error) {
+        solid_log(logger, Error, "Verify " << _path << ": " << _name << ": " << _error);
+        _rresult.entry_name_ = _name;
+        _rresult.error_      = _error;
+        return false;
+    };
+
+    if (!zip_file.open(_path) || !zip::read_central_directory(zip_file, entries)) {
+        return fail("", "cannot read the central directory");
+    }
+    for (const auto& entry : entries) {
+        if (!zip::is_safe_name(entry.name_)) {
+            return fail(entry.name_, "unsafe name, absolute or with \"..\" components");
+        }
+    }
+
+    // the indexes and the manifest are small and needed to check the other entries
+    const ArchiveEntry* pmanifest = nullptr;
+    for (const auto& entry : entries) {
+        if (SolidIndex::isIndexName(entry.name_)) {
+            string data;
+            if (!zip::read_entry(zip_file, entry, 0, entry.size_, data) || !solid_index.load(data)) {
+                return fail("", "invalid solid index");
+            }
+        } else if (AliasIndex::isName(entry.name_)) {
+            string data;
+            if (!zip::read_entry(zip_file, entry, 0, entry.size_, data) || !alias_index.load(data)) {
+                return fail("", "invalid alias index");
+            }
+        } else if (ArchiveManifest::isName(entry.name_)) {
+            pmanifest = &entry;
+        }
+    }
+    if (!verify_aliases(entries, alias_index, _options, error)) {
+        return fail("", error);
+    }
+    if (pmanifest != nullptr && !verify_manifest(zip_file, *pmanifest, entries, solid_index, alias_index, error)) {
+        return fail("", error);
+    }
+
+    const size_t     hardware_count = std::max<size_t>(thread::hardware_concurrency(), 1);
+    const size_t     worker_count   = std::min(_options.worker_count_ != 0 ? _options.worker_count_ : hardware_count, std::max<size_t>(entries.size(), 1));
+    atomic<size_t>   next_entry{0};
+    atomic<uint64_t> size{0};
+    atomic<bool>     failed{false};
+    mutex            failure_mutex;
+    size_t           failed_index = numeric_limits<size_t>::max();
+
+    // entries are taken in archive order, so every entry before a failing one is checked
+    // before the workers stop and the lowest failing index is the first failure
+    auto worker_lambda = [&]() {
+        vector<uint8_t> meta;
+        string          entry_error;
+        while (!failed) {
+            const size_t index = next_entry.fetch_add(1);
+            if (index >= entries.size()) {
+                break;
+            }
+            if (!verify_entry(zip_file, entries[index], solid_index, _options, meta, entry_error)) {
+                lock_guard<mutex> lock(failure_mutex);
+                if (index < failed_index) {
+                    failed_index = index;
+                    error        = entry_error;
+                }
+                failed = true;
+                break;
+            }
+            size += entries[index].size_;
+        }
+    };
+
+    if (worker_count == 1) {
+        worker_lambda();
+    } else {
+        vector<thread> workers;
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers.emplace_back(worker_lambda);
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+    if (failed) {
+        return fail(entries[failed_index].name_, error);
+    }
+    _rresult.entry_count_ = entries.size();
+    _rresult.size_        = size;
+    solid_log(logger, Info, "Verified " << _path << ": " << entries.size() << " entries, " << _rresult.size_ << " bytes");
+    return true;
+}
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,516 @@
+// myapps/common/utility/src/chunk_store.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "myapps/common/utility/chunk_store.hpp"
+#include "myapps/common/utility/encode.hpp"
+#include "solid/system/log.hpp"
+#include "zip_format.hpp"
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <zlib.h>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::chunk_store");
+
+constexpr const char* manifest_magic   = "myapps.chunks";
+constexpr uint32_t    manifest_version = 1;
+
+constexpr size_t chunk_min_size = 16 * 1024;
+constexpr size_t chunk_avg_size = 64 * 1024;
+constexpr size_t chunk_max_size = 256 * 1024;
+// normalized chunking: harder cut condition before the average size, easier after
+constexpr uint64_t chunk_mask_small = ((1ULL << 18) - 1) << 46;
+constexpr uint64_t chunk_mask_large = ((1ULL << 14) - 1) << 50;
+
+constexpr uint8_t chunk_stored  = 0;
+constexpr uint8_t chunk_deflate = 1;
+
+enum struct EntryKindE : uint8_t {
+    Directory = 0,
+    File,
+};
+
+struct GearTable {
+    uint64_t value_[256];
+
+    GearTable()
+    {
+        // splitmix64 - fixed seed, the table is part of the format
+        uint64_t x = 0x9e3779b97f4a7c15ULL;
+        for (auto& v : value_) {
+            x += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = x;
+            z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z          = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            v          = z ^ (z >> 31);
+        }
+    }
+};
+
+const GearTable gear_table;
+
+// length of the next chunk at the start of [_pdata, _pdata + _size)
+size_t chunk_cut(const uint8_t* _pdata, const size_t _size)
+{
+    if (_size <= chunk_min_size) {
+        return _size;
+    }
+    const size_t normal_size = std::min(_size, chunk_avg_size);
+    const size_t max_size    = std::min(_size, chunk_max_size);
+    uint64_t     hash        = 0;
+    size_t       i           = chunk_min_size;
+
+    for (; i < normal_size; ++i) {
+        hash = (hash << 1) + gear_table.value_[_pdata[i]];
+        if ((hash & chunk_mask_small) == 0) {
+            return i + 1;
+        }
+    }
+    for (; i < max_size; ++i) {
+        hash = (hash << 1) + gear_table.value_[_pdata[i]];
+        if ((hash & chunk_mask_large) == 0) {
+            return i + 1;
+        }
+    }
+    return i;
+}
+
+struct Chunk {
+    string   digest_;
+    uint32_t size_ = 0;
+};
+
+struct Entry {
+    EntryKindE      kind_ = EntryKindE::File;
+    string          name_;
+    int64_t         mtime_ = 0;
+    uint64_t        size_  = 0;
+    vector<uint8_t> meta_;
+    vector<Chunk>   chunks_;
+};
+
+boost::filesystem::path chunk_path(const std::string& _store_path, const std::string& _digest)
+{
+    const string hex = hex_encode(_digest);
+    return boost::filesystem::path(_store_path) / hex.substr(0, 2) / hex;
+}
+
+bool store_chunk(const std::string& _store_path, const string& _data, const string& _digest, ChunkStoreStatistics& _rstatistics)
+{
+    using namespace boost::filesystem;
+
+    boost::system::error_code err;
+    const path                chunk_file = chunk_path(_store_path, _digest);
+
+    if (exists(chunk_file, err)) {
+        return true;
+    }
+    create_directories(chunk_file.parent_path(), err);
+
+    uLongf out_len = compressBound(_data.size());
+    string out(out_len + 1, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(&out[1]), &out_len, reinterpret_cast<const Bytef*>(_data.data()), _data.size(), Z_DEFAULT_COMPRESSION) == Z_OK && out_len < _data.size()) {
+        out[0] = static_cast<char>(chunk_deflate);
+        out.resize(out_len + 1);
+    } else {
+        out[0] = static_cast<char>(chunk_stored);
+        out.replace(1, string::npos, _data);
+    }
+
+    // write aside and rename, so a chunk file is either complete or missing
+    path tmp_file = chunk_file;
+    tmp_file += unique_path(".%%%%%%%%.tmp");
+    {
+        boost::filesystem::ofstream ofs(tmp_file, std::ios::binary);
+        ofs.write(out.data(), out.size());
+        if (!ofs.good()) {
+            solid_log(logger, Error, "Writing chunk " << chunk_file.generic_string() << " failed");
+            remove(tmp_file, err);
+            return false;
+        }
+    }
+    rename(tmp_file, chunk_file, err);
+    if (err) {
+        remove(tmp_file, err);
+        return exists(chunk_file, err);
+    }
+    ++_rstatistics.new_chunk_count_;
+    _rstatistics.new_chunk_size_ += out.size();
+    return true;
+}
+
+bool load_chunk(const std::string& _store_path, const Chunk& _rchunk, string& _rdata)
+{
+    boost::filesystem::ifstream ifs(chunk_path(_store_path, _rchunk.digest_), std::ios::binary);
+    string                      in((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    if (in.empty()) {
+        solid_log(logger, Error, "Missing chunk " << hex_encode(_rchunk.digest_));
+        return false;
+    }
+    if (static_cast<uint8_t>(in[0]) == chunk_stored) {
+        _rdata.assign(in, 1, string::npos);
+    } else {
+        uLongf out_len = _rchunk.size_;
+        _rdata.resize(_rchunk.size_);
+        if (uncompress(reinterpret_cast<Bytef*>(&_rdata[0]), &out_len, reinterpret_cast<const Bytef*>(in.data() + 1), in.size() - 1) != Z_OK) {
+            _rdata.clear();
+        }
+        _rdata.resize(out_len);
+    }
+    if (_rdata.size() != _rchunk.size_ || sha256(_rdata) != _rchunk.digest_) {
+        solid_log(logger, Error, "Corrupted chunk " << hex_encode(_rchunk.digest_));
+        return false;
+    }
+    return true;
+}
+
+bool chunk_file(const std::string& _store_path, const boost::filesystem::path& _path, Entry& _rentry, ChunkStoreStatistics& _rstatistics)
+{
+    boost::filesystem::ifstream ifs(_path, std::ios::binary);
+    constexpr size_t            buf_capacity = 16 * chunk_max_size;
+    string                      buf(buf_capacity, '\0');
+    string                      chunk;
+    size_t                      begin = 0;
+    size_t                      end   = 0;
+    bool                        eof   = false;
+
+    if (!ifs) {
+        solid_log(logger, Error, "Cannot open " << _path.generic_string());
+        return false;
+    }
+
+    while (true) {
+        if (!eof && (end - begin) < chunk_max_size) {
+            buf.erase(0, begin);
+            end -= begin;
+            begin = 0;
+            buf.resize(buf_capacity);
+            ifs.read(&buf[end], buf_capacity - end);
+            end += ifs.gcount();
+            eof = !ifs;
+        }
+        if (begin == end) {
+            break;
+        }
+        const size_t len = chunk_cut(reinterpret_cast<const uint8_t*>(buf.data() + begin), end - begin);
+        chunk.assign(buf, begin, len);
+        begin += len;
+
+        Chunk c;
+        c.digest_ = sha256(chunk);
+        c.size_   = static_cast<uint32_t>(len);
+        if (!store_chunk(_store_path, chunk, c.digest_, _rstatistics)) {
+            return false;
+        }
+        _rentry.size_ += len;
+        _rentry.chunks_.emplace_back(std::move(c));
+    }
+    _rstatistics.chunk_count_ += _rentry.chunks_.size();
+    return ifs.eof();
+}
+
+bool chunk_dir(
+    const std::string& _store_path, const boost::filesystem::path& _path, const size_t _base_path_len,
+    vector<Entry>& _rentries, ChunkStoreStatistics& _rstatistics, const CreateFileMetaFunctionT& _rmeta_fnc)
+{
+    using namespace boost::filesystem;
+
+    for (directory_entry& x : directory_iterator(_path)) {
+        const auto& p = x.path();
+        Entry       entry;
+        entry.name_  = p.generic_string().substr(_base_path_len);
+        entry.mtime_ = last_write_time(p);
+        if (is_directory(p)) {
+            entry.kind_ = EntryKindE::Directory;
+            entry.name_ += '/';
+            _rentries.emplace_back(std::move(entry));
+            if (!chunk_dir(_store_path, p, _base_path_len, _rentries, _rstatistics, _rmeta_fnc)) {
+                return false;
+            }
+        } else {
+            _rmeta_fnc(p.generic_string(), entry.meta_);
+            if (!chunk_file(_store_path, p, entry, _rstatistics)) {
+                return false;
+            }
+            solid_log(logger, Info, "" << entry.name_ << " chunks = " << entry.chunks_.size());
+            _rentries.emplace_back(std::move(entry));
+        }
+    }
+    return true;
+}
+
+bool save_manifest(const std::string& _manifest_path, const vector<Entry>& _rentries)
+{
+    string buf = manifest_magic;
+    zip::store_u32(buf, manifest_version);
+    zip::store_u64(buf, _rentries.size());
+    for (const auto& entry : _rentries) {
+        if (entry.name_.size() > zip::max_u16 || entry.meta_.size() > zip::max_u16) {
+            solid_log(logger, Error, "Name or meta too long: " << entry.name_);
+            return false;
+        }
+        buf += static_cast<char>(entry.kind_);
+        zip::store_u16(buf, static_cast<uint16_t>(entry.name_.size()));
+        buf += entry.name_;
+        zip::store_u64(buf, static_cast<uint64_t>(entry.mtime_));
+        zip::store_u64(buf, entry.size_);
+        zip::store_u16(buf, static_cast<uint16_t>(entry.meta_.size()));
+        buf.append(reinterpret_cast<const char*>(entry.meta_.data()), entry.meta_.size());
+        zip::store_u32(buf, static_cast<uint32_t>(entry.chunks_.size()));
+        for (const auto& chunk : entry.chunks_) {
+            buf += chunk.digest_;
+            zip::store_u32(buf, chunk.size_);
+        }
+    }
+    std::ofstream ofs(_manifest_path, std::ofstream::binary);
+    ofs.write(buf.data(), buf.size());
+    return ofs.good();
+}
+
+class ManifestReader {
+    const string& rbuf_;
+    size_t        offset_ = 0;
+    bool          ok_     = true;
+
+public:
+    ManifestReader(const string& _rbuf)
+        : rbuf_(_rbuf)
+    {
+    }
+
+    bool ok() const { return ok_; }
+
+    const char* take(const size_t _len)
+    {
+        if (!ok_ || rbuf_.size() - offset_ < _len) {
+            ok_ = false;
+            return nullptr;
+        }
+        const char* p = rbuf_.data() + offset_;
+        offset_ += _len;
+        return p;
+    }
+
+    uint8_t u8()
+    {
+        const char* p = take(1);
+        return p ? static_cast<uint8_t>(*p) : 0;
+    }
+    uint16_t u16()
+    {
+        const char* p = take(2);
+        return p ? zip::load_u16(p) : 0;
+    }
+    uint32_t u32()
+    {
+        const char* p = take(4);
+        return p ? zip::load_u32(p) : 0;
+    }
+    uint64_t u64()
+    {
+        const char* p = take(8);
+        return p ? zip::load_u64(p) : 0;
+    }
+    string str(const size_t _len)
+    {
+        const char* p = take(_len);
+        return p ? string(p, _len) : string();
+    }
+};
+
+bool load_manifest(const std::string& _manifest_path, vector<Entry>& _rentries)
+{
+    std::ifstream  ifs(_manifest_path, std::ifstream::binary);
+    const string   buf((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ManifestReader reader(buf);
+    const size_t   digest_size = sha256(string()).size();
+
+    if (reader.str(strlen(manifest_magic)) != manifest_magic || reader.u32() != manifest_version) {
+        solid_log(logger, Error, "Invalid manifest: " << _manifest_path);
+        return false;
+    }
+    const uint64_t count = reader.u64();
+    for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+        Entry entry;
+        entry.kind_  = static_cast<EntryKindE>(reader.u8());
+        entry.name_  = reader.str(reader.u16());
+        entry.mtime_ = static_cast<int64_t>(reader.u64());
+        entry.size_  = reader.u64();
+
+        const string meta = reader.str(reader.u16());
+        entry.meta_.assign(meta.begin(), meta.end());
+
+        const uint32_t n    = reader.u32();
+        uint64_t       size = 0;
+        for (uint32_t j = 0; j < n && reader.ok(); ++j) {
+            Chunk chunk;
+            chunk.digest_ = reader.str(digest_size);
+            chunk.size_   = reader.u32();
+            size += chunk.size_;
+            entry.chunks_.emplace_back(std::move(chunk));
+        }
+        if (!reader.ok()) {
+            break;
+        }
+        // extraction writes under _root whatever the manifest names
+        if (!zip::is_safe_name(entry.name_) || size != entry.size_) {
+            solid_log(logger, Error, "Invalid manifest entry: " << entry.name_ << " in " << _manifest_path);
+            return false;
+        }
+        _rentries.emplace_back(std::move(entry));
+    }
+    if (!reader.ok()) {
+        solid_log(logger, Error, "Truncated manifest: " << _manifest_path);
+    }
+    return reader.ok();
+}
+
+} // namespace
+
+bool chunk_store_create(
+    const std::string& _store_path, const std::string& _manifest_path, std::string _root,
+    uint64_t& _runcompressed_size, ChunkStoreStatistics& _rstatistics,
+    CreateFileMetaFunctionT _meta_fnc)
+{
+    using namespace boost::filesystem;
+
+    boost::system::error_code err;
+    vector<Entry>             entries;
+
+    if (!_root.empty() && _root.back() != '/') {
+        _root += '/';
+    }
+
+    solid_log(logger, Info, "Create chunk manifest: " << _manifest_path << " from " << _root << " into " << _store_path);
+    _runcompressed_size = 0;
+    _rstatistics        = ChunkStoreStatistics{};
+
+    if (!is_directory(_root, err)) {
+        solid_log(logger, Error, "Path: " << _root << " not a directory");
+        return false;
+    }
+    create_directories(_store_path, err);
+
+    if (!chunk_dir(_store_path, _root, _root.size(), entries, _rstatistics, _meta_fnc)) {
+        return false;
+    }
+    for (const auto& entry : entries) {
+        _runcompressed_size += entry.size_;
+    }
+    return save_manifest(_manifest_path, entries);
+}
+
+bool chunk_store_create(
+    const std::string& _store_path, const std::string& _manifest_path, std::string _root,
+    uint64_t&               _runcompressed_size,
+    CreateFileMetaFunctionT _meta_fnc)
+{
+    ChunkStoreStatistics statistics;
+    return chunk_store_create(_store_path, _manifest_path, std::move(_root), _runcompressed_size, statistics, std::move(_meta_fnc));
+}
+
+bool chunk_store_missing(const std::string& _store_path, const std::string& _manifest_path, std::vector<std::string>& _rdigests)
+{
+    vector<Entry> entries;
+    if (!load_manifest(_manifest_path, entries)) {
+        return false;
+    }
+    boost::system::error_code err;
+    vector<string>            digests;
+    for (const auto& entry : entries) {
+        for (const auto& chunk : entry.chunks_) {
+            digests.emplace_back(chunk.digest_);
+        }
+    }
+    std::sort(digests.begin(), digests.end());
+    digests.erase(std::unique(digests.begin(), digests.end()), digests.end());
+    for (const auto& digest : digests) {
+        if (!boost::filesystem::exists(chunk_path(_store_path, digest), err)) {
+            _rdigests.emplace_back(hex_encode(digest));
+        }
+    }
+    return true;
+}
+
+bool do_chunk_store_extract(
+    const std::string& _store_path, const std::string& _manifest_path, const std::string& _root,
+    uint64_t&                   _runcompressed_size,
+    OnCreateDirectoryFunctionT& _on_create_dir_function,
+    CreateWriteFunctionT&       _create_file_writer_function)
+{
+    using namespace boost::filesystem;
+
+    boost::system::error_code error;
+    vector<Entry>             entries;
+    string                    data;
+
+    if (!load_manifest(_manifest_path, entries)) {
+        return false;
+    }
+
+    for (const auto& entry : entries) {
+        _runcompressed_size += entry.size_;
+        if (entry.kind_ == EntryKindE::Directory) {
+            if (!create_directory(_root + '/' + entry.name_, error) || !_on_create_dir_function(entry.name_.c_str())) {
+                return false;
+            }
+            solid_log(logger, Info, "created directory: " << entry.name_);
+            continue;
+        }
+        FileWriteFunctionT file_write_function = _create_file_writer_function(entry.name_.c_str(), entry.size_, entry.meta_.data(), static_cast<uint16_t>(entry.meta_.size()));
+        if (!file_write_function) {
+            return false;
+        }
+        for (const auto& chunk : entry.chunks_) {
+            if (!load_chunk(_store_path, chunk, data) || !file_write_function(data.data(), data.size())) {
+                return false;
+            }
+        }
+        solid_log(logger, Info, "Created file: " << entry.name_);
+    }
+    return true;
+}
+
+bool chunk_store_extract(const std::string& _store_path, const std::string& _manifest_path, const std::string& _root, uint64_t& _runcompressed_size)
+{
+    auto create_dir_lambda   = [](const char*) { return true; };
+    auto create_write_lambda = [&_root](const char* _file_name, uint64_t /*_size*/, const uint8_t*, uint16_t) {
+        std::ofstream ofs(_root + '/' + _file_name, std::ofstream::binary);
+        if (ofs) {
+            auto lambda = [ofs = std::move(ofs)](const char* _buf, size_t _len) mutable {
+                ofs.write(_buf, _len);
+                return ofs.good();
+            };
+            return FileWriteFunctionT{std::move(lambda)};
+        } else {
+            return FileWriteFunctionT{};
+        }
+    };
+    return chunk_store_extract(_store_path, _manifest_path, _root, _runcompressed_size, create_dir_lambda, create_write_lambda);
+}
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,193 @@
+// myapps/common/utility/src/crc32.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "crc32.hpp"
+#include <zlib.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MYAPPS_CRC32_PCLMUL 1
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MYAPPS_CRC32_TARGET
+#else
+#define MYAPPS_CRC32_TARGET __attribute__((target("pclmul,sse4.1")))
+#endif
+#endif
+
+namespace myapps {
+namespace utility {
+namespace zip {
+namespace {
+
+#ifdef MYAPPS_CRC32_PCLMUL
+
+// Folding by 4x128 bits, then Barrett reduction - "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction" (Intel), with the bit reflected constants
+// for the zip polynomial. _size is a multiple of 16, at least 64; _crc is not inverted.
+MYAPPS_CRC32_TARGET uint32_t crc32_pclmul(uint32_t _crc, const uint8_t* _buf, size_t _size)
+{
+    alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+    alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf + 0x00));
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf + 0x10));
+    x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf + 0x20));
+    x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(_crc)));
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+
+    _buf += 64;
+    _size -= 64;
+
+    while (_size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf + 0x30)));
+
+        _buf += 64;
+        _size -= 64;
+    }
+
+    // fold the four lanes into one
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    while (_size >= 16) {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_buf));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        _buf += 16;
+        _size -= 16;
+    }
+
+    // 128 to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+bool detect_pclmul()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) != 0 && (info[2] & (1 << 19)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+const bool has_pclmul = detect_pclmul();
+
+#else
+
+constexpr bool has_pclmul = false;
+
+#endif
+
+// below this zlib's tables are as fast as setting up the folding
+constexpr size_t pclmul_min_size = 64;
+
+uint32_t crc32_zlib(uint32_t _crc, const uint8_t* _buf, size_t _size)
+{
+    // crc32_z takes size_t, but is not in every zlib this may be built against
+    while (_size != 0) {
+        const uInt len = static_cast<uInt>(_size > 0x40000000 ? 0x40000000 : _size);
+        _crc           = static_cast<uint32_t>(::crc32(_crc, _buf, len));
+        _buf += len;
+        _size -= len;
+    }
+    return _crc;
+}
+
+} // namespace
+
+uint32_t crc32_update(uint32_t _crc, const void* _data, size_t _size)
+{
+    const auto* buf = static_cast<const uint8_t*>(_data);
+#ifdef MYAPPS_CRC32_PCLMUL
+    if (has_pclmul && _size >= pclmul_min_size) {
+        const size_t bulk = _size & ~static_cast<size_t>(15);
+        _crc              = ~crc32_pclmul(~_crc, buf, bulk);
+        buf += bulk;
+        _size -= bulk;
+    }
+#endif
+    return crc32_zlib(_crc, buf, _size);
+}
+
+bool crc32_accelerated()
+{
+    return has_pclmul;
+}
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
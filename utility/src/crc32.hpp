@@ -0,0 +1,37 @@
+// myapps/common/utility/src/crc32.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace myapps {
+namespace utility {
+namespace zip {
+
+// zip (ISO-HDLC) CRC-32, same results as zlib crc32(): _crc is the value returned by the
+// previous call, 0 to start.
+// On x86 with PCLMULQDQ the bulk is folded with carry-less multiplications, selected at
+// runtime; elsewhere zlib does the work. SSE4.2 crc32 is not usable: it computes CRC-32C.
+uint32_t crc32_update(uint32_t _crc, const void* _data, size_t _size);
+
+bool crc32_accelerated();
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
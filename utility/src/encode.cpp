@@ -77,6 +77,40 @@ std::string sha256(std::istream& _ris)
     return string(reinterpret_cast<char*>(md_value), md_len);
 }
 
+struct Sha256Hasher::Data {
+    DigestContextPtrT digest_ctx_ptr_{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+
+    Data()
+    {
+        EVP_DigestInit_ex(digest_ctx_ptr_.get(), EVP_sha3_256(), NULL);
+    }
+};
+
+Sha256Hasher::Sha256Hasher()
+    : pimpl_(std::make_unique<Data>())
+{
+}
+
+Sha256Hasher::~Sha256Hasher() = default;
+
+Sha256Hasher::Sha256Hasher(Sha256Hasher&&) noexcept            = default;
+Sha256Hasher& Sha256Hasher::operator=(Sha256Hasher&&) noexcept = default;
+
+void Sha256Hasher::update(const char* _data, const size_t _size)
+{
+    EVP_DigestUpdate(pimpl_->digest_ctx_ptr_.get(), _data, _size);
+}
+
+std::string Sha256Hasher::digest()
+{
+    unsigned char md_value[EVP_MAX_MD_SIZE];
+    unsigned int  md_len;
+
+    EVP_DigestFinal_ex(pimpl_->digest_ctx_ptr_.get(), md_value, &md_len);
+    EVP_DigestInit_ex(pimpl_->digest_ctx_ptr_.get(), EVP_sha3_256(), NULL);
+    return string(reinterpret_cast<char*>(md_value), md_len);
+}
+
 //-----------------------------------------------------------------------------
 // https://stackoverflow.com/questions/7053538/how-do-i-encode-a-string-to-base64-using-only-boost
 namespace {
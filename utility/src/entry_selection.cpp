@@ -0,0 +1,146 @@
+// myapps/common/utility/src/entry_selection.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "entry_selection.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+
+bool glob_match(const char* _pattern, const char* _name)
+{
+    for (; *_pattern != '\0'; ++_pattern, ++_name) {
+        if (*_pattern == '*') {
+            const bool across = _pattern[1] == '*';
+            _pattern += across ? 2 : 1;
+            for (;; ++_name) {
+                if (glob_match(_pattern, _name)) {
+                    return true;
+                }
+                if (*_name == '\0' || (!across && *_name == '/')) {
+                    return false;
+                }
+            }
+        }
+        const bool same = *_pattern == '?' ? *_name != '/' : *_name == *_pattern;
+        if (*_name == '\0' || !same) {
+            return false;
+        }
+    }
+    return *_name == '\0';
+}
+
+bool pattern_match(const string& _pattern, const string& _name)
+{
+    if (!_pattern.empty() && _pattern.back() == '/') {
+        return _name.compare(0, _pattern.size(), _pattern) == 0;
+    }
+    return glob_match(_pattern.c_str(), _name.c_str());
+}
+
+} // namespace
+
+bool ArchiveEntryFilter::operator()(const std::string& _name, const uint64_t _size) const
+{
+    if (!patterns_.empty() && std::none_of(patterns_.begin(), patterns_.end(), [&_name](const string& _pattern) { return pattern_match(_pattern, _name); })) {
+        return false;
+    }
+    return !predicate_ || predicate_(_name, _size);
+}
+
+bool EntrySelection::addFile(const std::string& _name, const uint64_t _size)
+{
+    if (all()) {
+        return true;
+    }
+    if (!rfilter_(_name, _size)) {
+        return false;
+    }
+    addParents(_name);
+    return true;
+}
+
+void EntrySelection::addSolid(const SolidIndex& _rindex)
+{
+    if (all()) {
+        return;
+    }
+    members_.resize(_rindex.members().size());
+    for (size_t i = 0; i < members_.size(); ++i) {
+        const auto& member = _rindex.members()[i];
+        members_[i]        = addFile(member.name_, member.size_);
+    }
+}
+
+void EntrySelection::addAliases(const AliasIndex& _rindex)
+{
+    if (all()) {
+        return;
+    }
+    aliases_.resize(_rindex.members().size());
+    for (size_t i = 0; i < aliases_.size(); ++i) {
+        const auto& member = _rindex.members()[i];
+        aliases_[i]        = addFile(member.name_, member.size_);
+    }
+}
+
+uint64_t EntrySelection::aliasSize(const AliasIndex& _rindex) const
+{
+    uint64_t size = 0;
+    for (size_t i = 0; i < _rindex.members().size(); ++i) {
+        if (all() || aliases_[i]) {
+            size += _rindex.members()[i].size_;
+        }
+    }
+    return size;
+}
+
+bool EntrySelection::directory(const std::string& _name) const
+{
+    return all() || directories_.count(_name) != 0 || rfilter_(_name, 0);
+}
+
+uint64_t EntrySelection::blockSize(const SolidIndex& _rindex, const uint32_t _block, bool& _rtaken) const
+{
+    const auto range = _rindex.blockRange(_block);
+    uint64_t   size  = 0;
+    _rtaken          = all();
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (all() || members_[i]) {
+            size += _rindex.members()[i].size_;
+            _rtaken = true;
+        }
+    }
+    return size;
+}
+
+void EntrySelection::addParents(const std::string& _name)
+{
+    // "a/b/c" -> "a/b/", "a/"; stops at the first one already known
+    for (size_t pos = _name.rfind('/', _name.size() - 2); pos != string::npos && pos != 0; pos = _name.rfind('/', pos - 1)) {
+        if (!directories_.emplace(_name, 0, pos + 1).second) {
+            break;
+        }
+    }
+}
+
+} // namespace utility
+} // namespace myapps
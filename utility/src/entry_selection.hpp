@@ -0,0 +1,70 @@
+// myapps/common/utility/src/entry_selection.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "archive_alias.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "solid_block.hpp"
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+
+// What an extraction takes under ArchiveExtractOptions::filter_.
+// Every file entry goes through addFile and the solid and alias indexes through addSolid and
+// addAliases before directories are asked for, since a directory is taken when it holds a
+// taken entry.
+class EntrySelection {
+    const ArchiveEntryFilter&       rfilter_;
+    std::unordered_set<std::string> directories_;
+    std::vector<bool>               members_; // solid members, by member index
+    std::vector<bool>               aliases_; // by alias index member
+
+public:
+    explicit EntrySelection(const ArchiveEntryFilter& _rfilter)
+        : rfilter_(_rfilter)
+    {
+    }
+
+    bool all() const { return rfilter_.empty(); }
+
+    bool addFile(const std::string& _name, uint64_t _size);
+    void addSolid(const SolidIndex& _rindex);
+    void addAliases(const AliasIndex& _rindex);
+
+    bool directory(const std::string& _name) const;
+
+    // nullptr when every member is taken, see SolidIndex::blockWriter
+    const std::vector<bool>* members() const { return all() ? nullptr : &members_; }
+    // nullptr when every alias is taken, see AliasIndex::fanOut
+    const std::vector<bool>* aliases() const { return all() ? nullptr : &aliases_; }
+
+    // uncompressed size of the taken aliases
+    uint64_t aliasSize(const AliasIndex& _rindex) const;
+
+    // uncompressed size of the taken members of _block; _rtaken: decompress the block
+    uint64_t blockSize(const SolidIndex& _rindex, uint32_t _block, bool& _rtaken) const;
+
+private:
+    void addParents(const std::string& _name);
+};
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,231 @@
+// myapps/common/utility/src/solid_block.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "solid_block.hpp"
+#include "solid/system/log.hpp"
+#include "zip_format.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace {
+solid::LoggerT logger("myapps::utility::archive");
+
+constexpr const char* solid_prefix       = ".myapps_solid/";
+constexpr const char* solid_index_suffix = "index";
+constexpr uint32_t    solid_index_magic  = 0x31494d53; // "SMI1"
+
+} // namespace
+
+bool SolidIndex::isIndexName(std::string_view _name)
+{
+    return _name == indexName();
+}
+
+bool SolidIndex::isBlockName(std::string_view _name, uint32_t& _rblock)
+{
+    const std::string_view prefix(solid_prefix);
+    if (_name.size() <= prefix.size() || _name.substr(0, prefix.size()) != prefix) {
+        return false;
+    }
+    uint32_t block = 0;
+    for (const char c : _name.substr(prefix.size())) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        block = block * 10 + (c - '0');
+    }
+    _rblock = block;
+    return true;
+}
+
+bool SolidIndex::isReservedName(std::string_view _name)
+{
+    const std::string_view prefix(solid_prefix);
+    return _name.substr(0, prefix.size()) == prefix;
+}
+
+std::string SolidIndex::indexName()
+{
+    return string(solid_prefix) + solid_index_suffix;
+}
+
+std::string SolidIndex::blockName(const uint32_t _block)
+{
+    return solid_prefix + to_string(_block);
+}
+
+std::string SolidIndex::store() const
+{
+    string buf;
+    zip::store_u32(buf, solid_index_magic);
+    zip::store_u32(buf, static_cast<uint32_t>(members_.size()));
+    for (const auto& member : members_) {
+        zip::store_u16(buf, static_cast<uint16_t>(member.name_.size()));
+        buf += member.name_;
+        zip::store_u64(buf, member.size_);
+        zip::store_u64(buf, static_cast<uint64_t>(member.mtime_));
+        zip::store_u32(buf, member.block_);
+        zip::store_u64(buf, member.offset_);
+        zip::store_u16(buf, static_cast<uint16_t>(member.meta_.size()));
+        buf.append(reinterpret_cast<const char*>(member.meta_.data()), member.meta_.size());
+    }
+    return buf;
+}
+
+bool SolidIndex::load(const std::string& _data)
+{
+    zip::BufferReader reader(_data);
+
+    members_.clear();
+    if (reader.u32() != solid_index_magic) {
+        solid_log(logger, Error, "Invalid solid index");
+        return false;
+    }
+    const uint32_t count = reader.u32();
+    for (uint32_t i = 0; i < count && reader.ok(); ++i) {
+        SolidMember member;
+        member.name_   = reader.str(reader.u16());
+        member.size_   = reader.u64();
+        member.mtime_  = static_cast<time_t>(reader.u64());
+        member.block_  = reader.u32();
+        member.offset_ = reader.u64();
+
+        const string meta = reader.str(reader.u16());
+        member.meta_.assign(meta.begin(), meta.end());
+        members_.emplace_back(std::move(member));
+    }
+    if (!reader.ok()) {
+        solid_log(logger, Error, "Truncated solid index");
+        members_.clear();
+        return false;
+    }
+    // blockRange and blockWriter rely on the members being sorted by block, each block
+    // packed from offset 0 without gaps
+    uint64_t offset = 0;
+    for (size_t i = 0; i < members_.size(); ++i) {
+        const auto& member = members_[i];
+        if (!zip::is_safe_name(member.name_)) {
+            solid_log(logger, Error, "Unsafe solid member name: " << member.name_);
+            members_.clear();
+            return false;
+        }
+        if (i == 0 || member.block_ != members_[i - 1].block_) {
+            offset = 0;
+        }
+        if ((i != 0 && member.block_ < members_[i - 1].block_) || member.offset_ != offset) {
+            solid_log(logger, Error, "Solid member out of place: " << member.name_);
+            members_.clear();
+            return false;
+        }
+        offset += member.size_;
+    }
+    return true;
+}
+
+std::pair<size_t, size_t> SolidIndex::blockRange(const uint32_t _block) const
+{
+    struct BlockLess {
+        bool operator()(const SolidMember& _a, const uint32_t _b) const { return _a.block_ < _b; }
+        bool operator()(const uint32_t _a, const SolidMember& _b) const { return _a < _b.block_; }
+    };
+    const auto range = std::equal_range(members_.begin(), members_.end(), _block, BlockLess());
+    return {range.first - members_.begin(), range.second - members_.begin()};
+}
+
+FileWriteFunctionT SolidIndex::indexWriter(const uint64_t _size)
+{
+    return [this, data = string(), _size](const char* _data, size_t _len) mutable {
+        data.append(_data, _len);
+        if (data.size() > _size) {
+            return false;
+        }
+        return data.size() < _size || load(data);
+    };
+}
+
+FileWriteFunctionT SolidIndex::blockWriter(const uint32_t _block, CreateWriteFunctionT& _rcreate_fnc, std::mutex* _pmutex, const std::vector<bool>* _ptaken) const
+{
+    struct BlockWriter {
+        const SolidIndex&        rindex_;
+        CreateWriteFunctionT&    rcreate_fnc_;
+        std::mutex*              pmutex_;
+        const std::vector<bool>* ptaken_;
+        size_t                   current_;
+        size_t                   end_;
+        uint64_t                 remaining_ = 0;
+        FileWriteFunctionT       writer_;
+
+        BlockWriter(const SolidIndex& _rindex, CreateWriteFunctionT& _rcreate_fnc, std::mutex* _pmutex, const std::vector<bool>* _ptaken, const std::pair<size_t, size_t>& _range)
+            : rindex_(_rindex)
+            , rcreate_fnc_(_rcreate_fnc)
+            , pmutex_(_pmutex)
+            , ptaken_(_ptaken)
+            , current_(_range.first)
+            , end_(_range.second)
+        {
+        }
+
+        bool operator()(const char* _data, size_t _size)
+        {
+            while (_size != 0) {
+                if (!writer_) {
+                    if (current_ == end_) {
+                        solid_log(logger, Error, "Solid block longer than its members");
+                        return false;
+                    }
+                    const auto& member = rindex_.members()[current_];
+                    if (ptaken_ != nullptr && !(*ptaken_)[current_]) {
+                        writer_ = [](const char*, size_t) { return true; };
+                    } else {
+                        unique_lock<mutex> lock;
+                        if (pmutex_ != nullptr) {
+                            lock = unique_lock<mutex>(*pmutex_);
+                        }
+                        writer_ = rcreate_fnc_(member.name_.c_str(), member.size_, member.meta_.data(), static_cast<uint16_t>(member.meta_.size()));
+                        if (!writer_) {
+                            return false;
+                        }
+                    }
+                    remaining_ = member.size_;
+                }
+                const size_t len = static_cast<size_t>(std::min<uint64_t>(_size, remaining_));
+                if (!writer_(_data, len)) {
+                    return false;
+                }
+                _data += len;
+                _size -= len;
+                remaining_ -= len;
+                if (remaining_ == 0) {
+                    writer_.reset();
+                    if (ptaken_ == nullptr || (*ptaken_)[current_]) {
+                        solid_log(logger, Info, "Created file: " << rindex_.members()[current_].name_);
+                    }
+                    ++current_;
+                }
+            }
+            return true;
+        }
+    };
+    return BlockWriter(*this, _rcreate_fnc, _pmutex, _ptaken, blockRange(_block));
+}
+
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,81 @@
+// myapps/common/utility/src/solid_block.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "myapps/common/utility/archive.hpp"
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+
+// Solid mode (ArchiveCreateOptions::solid_file_size_): small files are concatenated into
+// block entries named .myapps_solid/<n>, deflated together. The stored entry
+// .myapps_solid/index, written before any block, lists every member with its block and
+// offset. The extraction functions of this library expand blocks back into member files;
+// other zip tools see the blocks as plain files.
+
+struct SolidMember {
+    std::string          name_;
+    uint64_t             size_   = 0;
+    time_t               mtime_  = 0;
+    uint32_t             block_  = 0;
+    uint64_t             offset_ = 0;
+    std::vector<uint8_t> meta_;
+};
+
+class SolidIndex {
+    std::vector<SolidMember> members_; // by block, then by offset
+
+public:
+    static bool        isIndexName(std::string_view _name);
+    static bool        isBlockName(std::string_view _name, uint32_t& _rblock);
+    // the index, the blocks and anything else under their directory
+    static bool        isReservedName(std::string_view _name);
+    static std::string indexName();
+    static std::string blockName(uint32_t _block);
+
+    bool empty() const { return members_.empty(); }
+
+    const std::vector<SolidMember>& members() const { return members_; }
+
+    // names and metas within the uint16 sizes store writes them with
+    void add(SolidMember&& _rmember) { members_.emplace_back(std::move(_rmember)); }
+
+    std::string store() const;
+    bool        load(const std::string& _data);
+
+    // [first, last) members of _block
+    std::pair<size_t, size_t> blockRange(uint32_t _block) const;
+
+    // Writer for the uncompressed content of the index entry, loaded once _size bytes arrived.
+    FileWriteFunctionT indexWriter(uint64_t _size);
+
+    // Writer for the uncompressed content of a block entry: hands every member to a writer
+    // obtained from _rcreate_fnc (under *_pmutex when given). Member data is covered by the
+    // CRC of the block entry, checked by the caller as for any entry.
+    // With _ptaken (by member index) the members not taken are decompressed but dropped.
+    FileWriteFunctionT blockWriter(uint32_t _block, CreateWriteFunctionT& _rcreate_fnc, std::mutex* _pmutex = nullptr, const std::vector<bool>* _ptaken = nullptr) const;
+};
+
+} // namespace utility
+} // namespace myapps
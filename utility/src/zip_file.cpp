@@ -0,0 +1,164 @@
+// myapps/common/utility/src/zip_file.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "zip_file.hpp"
+#include <utility>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace myapps {
+namespace utility {
+namespace zip {
+
+File::~File()
+{
+    close();
+}
+
+File::File(File&& _other) noexcept
+    : handle_(std::exchange(_other.handle_, File().handle_))
+    , size_(std::exchange(_other.size_, 0))
+{
+}
+
+File& File::operator=(File&& _other) noexcept
+{
+    if (this != &_other) {
+        close();
+        handle_ = std::exchange(_other.handle_, File().handle_);
+        size_   = std::exchange(_other.size_, 0);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool File::open(const std::string& _path)
+{
+    close();
+    const int     wlen = MultiByteToWideChar(CP_UTF8, 0, _path.c_str(), -1, nullptr, 0);
+    std::wstring  wpath(wlen > 0 ? wlen : 0, L'\0');
+    LARGE_INTEGER file_size;
+    MultiByteToWideChar(CP_UTF8, 0, _path.c_str(), -1, &wpath[0], wlen);
+
+    HANDLE h = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    if (!GetFileSizeEx(h, &file_size)) {
+        CloseHandle(h);
+        return false;
+    }
+    handle_ = h;
+    size_   = static_cast<uint64_t>(file_size.QuadPart);
+    return true;
+}
+
+void File::close()
+{
+    if (handle_ != nullptr) {
+        CloseHandle(handle_);
+        handle_ = nullptr;
+        size_   = 0;
+    }
+}
+
+bool File::isOpen() const
+{
+    return handle_ != nullptr;
+}
+
+bool File::read(uint64_t _offset, char* _data, size_t _size) const
+{
+    while (_size != 0) {
+        OVERLAPPED ov{};
+        DWORD      done   = 0;
+        const auto tocopy = static_cast<DWORD>(_size > 0x40000000 ? 0x40000000 : _size);
+        ov.Offset         = static_cast<DWORD>(_offset & 0xffffffff);
+        ov.OffsetHigh     = static_cast<DWORD>(_offset >> 32);
+        if (!ReadFile(handle_, _data, tocopy, &done, &ov) || done == 0) {
+            return false;
+        }
+        _offset += done;
+        _data += done;
+        _size -= done;
+    }
+    return true;
+}
+
+#else
+
+bool File::open(const std::string& _path)
+{
+    close();
+    const int fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    handle_ = fd;
+    size_   = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void File::close()
+{
+    if (handle_ >= 0) {
+        ::close(handle_);
+        handle_ = -1;
+        size_   = 0;
+    }
+}
+
+bool File::isOpen() const
+{
+    return handle_ >= 0;
+}
+
+bool File::read(uint64_t _offset, char* _data, size_t _size) const
+{
+    while (_size != 0) {
+        const ssize_t rv = ::pread(handle_, _data, _size, static_cast<off_t>(_offset));
+        if (rv < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rv <= 0) {
+            return false;
+        }
+        _offset += rv;
+        _data += rv;
+        _size -= rv;
+    }
+    return true;
+}
+
+#endif
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,68 @@
+// myapps/common/utility/src/zip_file.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace myapps {
+namespace utility {
+namespace zip {
+
+// Read only file with positional reads: no shared file position, so one open
+// file can serve any number of threads.
+class File {
+public:
+#ifdef _WIN32
+    using NativeHandleT = void*;
+#else
+    using NativeHandleT = int;
+#endif
+    File() = default;
+    ~File();
+
+    File(const File&)            = delete;
+    File& operator=(const File&) = delete;
+    File(File&& _other) noexcept;
+    File& operator=(File&& _other) noexcept;
+
+    bool open(const std::string& _path);
+    void close();
+
+    bool isOpen() const;
+
+    uint64_t size() const { return size_; }
+
+    // reads exactly _size bytes at _offset
+    bool read(uint64_t _offset, char* _data, size_t _size) const;
+
+    NativeHandleT nativeHandle() const { return handle_; }
+
+private:
+#ifdef _WIN32
+    NativeHandleT handle_ = nullptr;
+#else
+    NativeHandleT handle_ = -1;
+#endif
+    uint64_t size_ = 0;
+};
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
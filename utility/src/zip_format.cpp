@@ -0,0 +1,86 @@
+// myapps/common/utility/src/zip_format.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "zip_format.hpp"
+
+namespace myapps {
+namespace utility {
+namespace zip {
+
+uint32_t dos_date_time(time_t _time)
+{
+    struct tm tm = {};
+#ifdef _WIN32
+    localtime_s(&tm, &_time);
+#else
+    localtime_r(&_time, &tm);
+#endif
+    if (tm.tm_year < 80) {
+        tm.tm_year = 80;
+        tm.tm_mon  = 0;
+        tm.tm_mday = 1;
+        tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    }
+    if (tm.tm_year > 207) { // the 7 bit year field ends with 2107
+        tm.tm_year = 207;
+        tm.tm_mon  = 11;
+        tm.tm_mday = 31;
+        tm.tm_hour = 23;
+        tm.tm_min  = 59;
+        tm.tm_sec  = 58;
+    }
+    const uint32_t date = ((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday;
+    const uint32_t time = (tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec >> 1);
+    return (date << 16) | time;
+}
+
+time_t from_dos_date_time(const uint32_t _date_time)
+{
+    struct tm tm = {};
+    tm.tm_year   = ((_date_time >> 25) & 0x7f) + 80;
+    tm.tm_mon    = ((_date_time >> 21) & 0x0f) - 1;
+    tm.tm_mday   = (_date_time >> 16) & 0x1f;
+    tm.tm_hour   = (_date_time >> 11) & 0x1f;
+    tm.tm_min    = (_date_time >> 5) & 0x3f;
+    tm.tm_sec    = (_date_time & 0x1f) << 1;
+    tm.tm_isdst  = -1;
+    return mktime(&tm);
+}
+
+bool is_safe_name(std::string_view _name)
+{
+    if (_name.empty() || _name[0] == '/' || _name[0] == '\\' || (_name.size() >= 2 && _name[1] == ':')) {
+        return false;
+    }
+    size_t pos = 0;
+    while (pos <= _name.size()) {
+        size_t end = _name.find_first_of("/\\", pos);
+        if (end == std::string_view::npos) {
+            end = _name.size();
+        }
+        if (_name.substr(pos, end - pos) == "..") {
+            return false;
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,164 @@
+// myapps/common/utility/src/zip_format.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace myapps {
+namespace utility {
+namespace zip {
+
+// Plain PKWARE APPNOTE layout helpers shared by the archive writers and readers.
+
+constexpr uint32_t local_file_header_signature    = 0x04034b50;
+constexpr uint32_t data_descriptor_signature      = 0x08074b50;
+constexpr uint32_t central_file_header_signature  = 0x02014b50;
+constexpr uint32_t zip64_end_of_central_signature = 0x06064b50;
+constexpr uint32_t zip64_locator_signature        = 0x07064b50;
+constexpr uint32_t end_of_central_signature       = 0x06054b50;
+
+constexpr size_t local_file_header_size    = 30;
+constexpr size_t central_file_header_size  = 46;
+constexpr size_t end_of_central_size       = 22;
+constexpr size_t zip64_end_of_central_size = 56;
+constexpr size_t zip64_locator_size        = 20;
+
+constexpr uint16_t zip64_extra_field_id = 0x0001;
+constexpr uint16_t meta_extra_field_id  = 0x3333;
+// uncompressed size (uint64) in local headers whose sizes are deferred to the data descriptor,
+// so that streaming readers know it upfront
+constexpr uint16_t size_extra_field_id = 0x3334;
+
+constexpr uint16_t method_store   = 0;
+constexpr uint16_t method_deflate = 8;
+
+constexpr uint16_t flag_data_descriptor = 1 << 3;
+constexpr uint16_t flag_utf8            = 1 << 11;
+
+constexpr uint16_t version_default = 20;
+constexpr uint16_t version_zip64   = 45;
+constexpr uint16_t made_by_unix    = 3 << 8;
+
+constexpr uint32_t max_u16 = 0xffff;
+constexpr uint32_t max_u32 = 0xffffffff;
+
+// the largest file meta an entry can carry: the meta extra field shares the local extra
+// field (uint16 sized) with the writer's own fields
+constexpr uint32_t max_meta_size = max_u16 - 64;
+
+inline void store_u16(std::string& _rbuf, const uint16_t _v)
+{
+    _rbuf += static_cast<char>(_v & 0xff);
+    _rbuf += static_cast<char>((_v >> 8) & 0xff);
+}
+
+inline void store_u32(std::string& _rbuf, const uint32_t _v)
+{
+    store_u16(_rbuf, static_cast<uint16_t>(_v & 0xffff));
+    store_u16(_rbuf, static_cast<uint16_t>(_v >> 16));
+}
+
+inline void store_u64(std::string& _rbuf, const uint64_t _v)
+{
+    store_u32(_rbuf, static_cast<uint32_t>(_v & 0xffffffff));
+    store_u32(_rbuf, static_cast<uint32_t>(_v >> 32));
+}
+
+inline uint16_t load_u16(const char* _p)
+{
+    const auto* p = reinterpret_cast<const uint8_t*>(_p);
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t load_u32(const char* _p)
+{
+    return load_u16(_p) | (static_cast<uint32_t>(load_u16(_p + 2)) << 16);
+}
+
+inline uint64_t load_u64(const char* _p)
+{
+    return load_u32(_p) | (static_cast<uint64_t>(load_u32(_p + 4)) << 32);
+}
+
+// Bounds checked little endian reader over the content of our own entries (solid index,
+// manifest): once a read runs past the end, ok() is false and every read returns zero.
+class BufferReader {
+    const std::string& rbuf_;
+    size_t             offset_ = 0;
+    bool               ok_     = true;
+
+public:
+    explicit BufferReader(const std::string& _rbuf)
+        : rbuf_(_rbuf)
+    {
+    }
+
+    bool ok() const { return ok_; }
+
+    const char* take(const size_t _len)
+    {
+        if (!ok_ || rbuf_.size() - offset_ < _len) {
+            ok_ = false;
+            return nullptr;
+        }
+        const char* p = rbuf_.data() + offset_;
+        offset_ += _len;
+        return p;
+    }
+
+    uint8_t u8()
+    {
+        const char* p = take(1);
+        return p ? static_cast<uint8_t>(*p) : 0;
+    }
+    uint16_t u16()
+    {
+        const char* p = take(2);
+        return p ? load_u16(p) : 0;
+    }
+    uint32_t u32()
+    {
+        const char* p = take(4);
+        return p ? load_u32(p) : 0;
+    }
+    uint64_t u64()
+    {
+        const char* p = take(8);
+        return p ? load_u64(p) : 0;
+    }
+    std::string str(const size_t _len)
+    {
+        const char* p = take(_len);
+        return p ? std::string(p, _len) : std::string();
+    }
+};
+
+// MS-DOS date in the high 16 bits, MS-DOS time in the low 16 bits, local time like libzip.
+uint32_t dos_date_time(time_t _time);
+time_t   from_dos_date_time(uint32_t _date_time);
+
+// a name that stays under the extraction root: not empty, not absolute (leading slash or
+// backslash, drive letter) and without ".." components, backslashes counting as separators
+bool is_safe_name(std::string_view _name);
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,380 @@
+// myapps/common/utility/src/zip_reader.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "zip_reader.hpp"
+#include "crc32.hpp"
+#include "solid/system/log.hpp"
+#include "zip_format.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <zlib.h>
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace zip {
+namespace {
+solid::LoggerT logger("myapps::utility::zip");
+
+bool find_end_of_central(const File& _rfile, uint64_t& _rcount, uint64_t& _rcentral_size, uint64_t& _rcentral_offset)
+{
+    const uint64_t file_size = _rfile.size();
+    if (file_size < end_of_central_size) {
+        return false;
+    }
+    // the end record is followed by at most a 64KB comment
+    const uint64_t tail_size = std::min<uint64_t>(file_size, end_of_central_size + max_u16);
+    const uint64_t tail_pos  = file_size - tail_size;
+    string         tail(tail_size, '\0');
+
+    if (!_rfile.read(tail_pos, &tail[0], tail.size())) {
+        return false;
+    }
+    size_t pos = tail.size() - end_of_central_size + 1;
+    do {
+        --pos;
+        if (load_u32(tail.data() + pos) == end_of_central_signature) {
+            break;
+        }
+    } while (pos != 0);
+
+    if (load_u32(tail.data() + pos) != end_of_central_signature) {
+        return false;
+    }
+    const char* p    = tail.data() + pos;
+    _rcount          = load_u16(p + 10);
+    _rcentral_size   = load_u32(p + 12);
+    _rcentral_offset = load_u32(p + 16);
+
+    if (_rcount != max_u16 && _rcentral_size != max_u32 && _rcentral_offset != max_u32) {
+        return true;
+    }
+
+    const uint64_t end_pos = tail_pos + pos;
+    char           locator[zip64_locator_size];
+    char           end64[zip64_end_of_central_size];
+    if (end_pos < zip64_locator_size || !_rfile.read(end_pos - zip64_locator_size, locator, sizeof(locator)) || load_u32(locator) != zip64_locator_signature) {
+        return false;
+    }
+    if (!_rfile.read(load_u64(locator + 8), end64, sizeof(end64)) || load_u32(end64) != zip64_end_of_central_signature) {
+        return false;
+    }
+    _rcount          = load_u64(end64 + 32);
+    _rcentral_size   = load_u64(end64 + 40);
+    _rcentral_offset = load_u64(end64 + 48);
+    return true;
+}
+
+} // namespace
+
+bool read_central_directory(const File& _rfile, std::vector<ArchiveEntry>& _rentries)
+{
+    uint64_t count          = 0;
+    uint64_t central_size   = 0;
+    uint64_t central_offset = 0;
+
+    if (!find_end_of_central(_rfile, count, central_size, central_offset)) {
+        solid_log(logger, Error, "No valid end of central directory");
+        return false;
+    }
+    // the end record is not trusted: the directory must lie inside the file and hold count headers
+    if (central_size > _rfile.size() || central_offset > _rfile.size() - central_size || count > central_size / central_file_header_size) {
+        solid_log(logger, Error, "Inconsistent end of central directory: " << count << " entries, " << central_size << " bytes at " << central_offset);
+        return false;
+    }
+
+    string central(central_size, '\0');
+    if (!_rfile.read(central_offset, &central[0], central.size())) {
+        return false;
+    }
+
+    _rentries.clear();
+    _rentries.reserve(count);
+
+    // mktime dominates parsing; entries of one archive share few distinct timestamps
+    unordered_map<uint32_t, time_t> mtimes;
+
+    size_t pos = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (central.size() - pos < central_file_header_size || load_u32(central.data() + pos) != central_file_header_signature) {
+            solid_log(logger, Error, "Invalid central directory entry " << i);
+            return false;
+        }
+        const char*    p            = central.data() + pos;
+        const uint16_t name_size    = load_u16(p + 28);
+        const uint16_t extra_size   = load_u16(p + 30);
+        const uint16_t comment_size = load_u16(p + 32);
+
+        if (central.size() - pos - central_file_header_size < static_cast<size_t>(name_size) + extra_size + comment_size) {
+            solid_log(logger, Error, "Truncated central directory entry " << i);
+            return false;
+        }
+
+        const uint32_t dos_time = load_u32(p + 12);
+        auto           mtime_it = mtimes.find(dos_time);
+        if (mtime_it == mtimes.end()) {
+            mtime_it = mtimes.emplace(dos_time, from_dos_date_time(dos_time)).first;
+        }
+
+        ArchiveEntry entry;
+        entry.method_          = load_u16(p + 10);
+        entry.mtime_           = mtime_it->second;
+        entry.crc_             = load_u32(p + 16);
+        entry.compressed_size_ = load_u32(p + 20);
+        entry.size_            = load_u32(p + 24);
+        entry.local_offset_    = load_u32(p + 42);
+        entry.name_.assign(p + central_file_header_size, name_size);
+
+        const char* extra     = p + central_file_header_size + name_size;
+        const char* extra_end = extra + extra_size;
+        while (extra_end - extra >= 4) {
+            const uint16_t id   = load_u16(extra);
+            const uint16_t size = load_u16(extra + 2);
+            const char*    data = extra + 4;
+            if (extra_end - data < size) {
+                break;
+            }
+            if (id == zip64_extra_field_id) {
+                const char* field = data;
+                const char* end   = data + size;
+                if (entry.size_ == max_u32 && end - field >= 8) {
+                    entry.size_ = load_u64(field);
+                    field += 8;
+                }
+                if (entry.compressed_size_ == max_u32 && end - field >= 8) {
+                    entry.compressed_size_ = load_u64(field);
+                    field += 8;
+                }
+                if (entry.local_offset_ == max_u32 && end - field >= 8) {
+                    entry.local_offset_ = load_u64(field);
+                }
+            }
+            extra = data + size;
+        }
+
+        _rentries.emplace_back(std::move(entry));
+        pos += central_file_header_size + name_size + extra_size + comment_size;
+    }
+    return true;
+}
+
+bool read_local_header(const File& _rfile, const ArchiveEntry& _rentry, uint64_t& _rdata_offset, std::vector<uint8_t>* _pmeta, const bool _strict)
+{
+    char header[local_file_header_size];
+    if (!_rfile.read(_rentry.local_offset_, header, sizeof(header)) || load_u32(header) != local_file_header_signature) {
+        solid_log(logger, Error, "Invalid local header for " << _rentry.name_);
+        return false;
+    }
+    const uint16_t name_size  = load_u16(header + 26);
+    const uint16_t extra_size = load_u16(header + 28);
+
+    _rdata_offset = _rentry.local_offset_ + local_file_header_size + name_size + extra_size;
+    if (_rdata_offset + _rentry.compressed_size_ > _rfile.size()) {
+        solid_log(logger, Error, "Entry data out of bounds for " << _rentry.name_);
+        return false;
+    }
+
+    if (_pmeta != nullptr) {
+        _pmeta->clear();
+        string extra(extra_size, '\0');
+        if (!_rfile.read(_rentry.local_offset_ + local_file_header_size + name_size, &extra[0], extra.size())) {
+            return false;
+        }
+        size_t pos = 0;
+        while (extra.size() - pos >= 4) {
+            const uint16_t id   = load_u16(extra.data() + pos);
+            const uint16_t size = load_u16(extra.data() + pos + 2);
+            pos += 4;
+            if (extra.size() - pos < size) {
+                if (_strict) {
+                    solid_log(logger, Error, "Malformed extra field " << id << " for " << _rentry.name_);
+                    return false;
+                }
+                break;
+            }
+            if (id == meta_extra_field_id) {
+                _pmeta->assign(extra.data() + pos, extra.data() + pos + size);
+                if (!_strict) {
+                    break;
+                }
+            }
+            pos += size;
+        }
+    }
+    return true;
+}
+
+bool read_entry(const File& _rfile, const ArchiveEntry& _rentry, uint64_t _offset, uint64_t _len, std::string& _rdata)
+{
+    uint64_t data_offset = 0;
+
+    _rdata.clear();
+    if (!read_local_header(_rfile, _rentry, data_offset)) {
+        return false;
+    }
+    if (_offset >= _rentry.size_) {
+        return true;
+    }
+    _len = std::min(_len, _rentry.size_ - _offset);
+
+    const bool whole = _offset == 0 && _len == _rentry.size_;
+
+    if (_rentry.method_ == method_store) {
+        _rdata.resize(_len);
+        if (!_rfile.read(data_offset + _offset, &_rdata[0], _len)) {
+            _rdata.clear();
+            return false;
+        }
+    } else if (_rentry.method_ == method_deflate) {
+        z_stream stream{};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            return false;
+        }
+        string   in(read_buffer_size, '\0');
+        string   out(read_buffer_size, '\0');
+        uint64_t in_pos  = 0;
+        uint64_t out_pos = 0; // uncompressed offset of out[0]
+        int      rv      = Z_OK;
+
+        _rdata.reserve(_len);
+        while (rv != Z_STREAM_END && _rdata.size() < _len) {
+            if (stream.avail_in == 0) {
+                const size_t toread = static_cast<size_t>(std::min<uint64_t>(in.size(), _rentry.compressed_size_ - in_pos));
+                if (toread == 0 || !_rfile.read(data_offset + in_pos, &in[0], toread)) {
+                    break;
+                }
+                in_pos += toread;
+                stream.next_in  = reinterpret_cast<Bytef*>(&in[0]);
+                stream.avail_in = static_cast<uInt>(toread);
+            }
+            stream.next_out  = reinterpret_cast<Bytef*>(&out[0]);
+            stream.avail_out = static_cast<uInt>(out.size());
+
+            rv = inflate(&stream, Z_NO_FLUSH);
+            if (rv != Z_OK && rv != Z_STREAM_END) {
+                break;
+            }
+            const uint64_t produced = out.size() - stream.avail_out;
+            if (out_pos + produced > _offset) {
+                const uint64_t skip = _offset > out_pos ? _offset - out_pos : 0;
+                _rdata.append(out.data() + skip, static_cast<size_t>(std::min<uint64_t>(produced - skip, _len - _rdata.size())));
+            }
+            out_pos += produced;
+        }
+        inflateEnd(&stream);
+        if (_rdata.size() != _len) {
+            solid_log(logger, Error, "Inflate failed for " << _rentry.name_);
+            _rdata.clear();
+            return false;
+        }
+    } else {
+        solid_log(logger, Error, "Unsupported compression method " << _rentry.method_ << " for " << _rentry.name_);
+        return false;
+    }
+
+    if (whole && crc32_update(0, _rdata.data(), _rdata.size()) != _rentry.crc_) {
+        solid_log(logger, Error, "CRC mismatch for " << _rentry.name_);
+        _rdata.clear();
+        return false;
+    }
+    return true;
+}
+
+bool read_entry(const File& _rfile, const ArchiveEntry& _rentry, const uint64_t _data_offset, const FileWriteFunctionT& _rwrite_fnc)
+{
+    string   in(read_buffer_size, '\0');
+    uint64_t in_pos = 0;
+    uint64_t size   = 0;
+    uint32_t crc    = 0;
+
+    if (_rentry.method_ == method_store) {
+        if (_rentry.compressed_size_ != _rentry.size_) {
+            solid_log(logger, Error, "Size mismatch for stored " << _rentry.name_);
+            return false;
+        }
+        while (in_pos < _rentry.compressed_size_) {
+            const size_t toread = static_cast<size_t>(std::min<uint64_t>(in.size(), _rentry.compressed_size_ - in_pos));
+            if (!_rfile.read(_data_offset + in_pos, &in[0], toread)) {
+                return false;
+            }
+            in_pos += toread;
+            crc = crc32_update(crc, in.data(), toread);
+            if (!_rwrite_fnc(in.data(), toread)) {
+                return false;
+            }
+        }
+        size = in_pos;
+    } else if (_rentry.method_ == method_deflate) {
+        z_stream stream{};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            return false;
+        }
+        string out(read_buffer_size, '\0');
+        int    rv = Z_OK;
+        while (rv != Z_STREAM_END) {
+            if (stream.avail_in == 0) {
+                const size_t toread = static_cast<size_t>(std::min<uint64_t>(in.size(), _rentry.compressed_size_ - in_pos));
+                if (toread == 0 || !_rfile.read(_data_offset + in_pos, &in[0], toread)) {
+                    break;
+                }
+                in_pos += toread;
+                stream.next_in  = reinterpret_cast<Bytef*>(&in[0]);
+                stream.avail_in = static_cast<uInt>(toread);
+            }
+            stream.next_out  = reinterpret_cast<Bytef*>(&out[0]);
+            stream.avail_out = static_cast<uInt>(out.size());
+
+            rv = inflate(&stream, Z_NO_FLUSH);
+            if (rv != Z_OK && rv != Z_STREAM_END) {
+                break;
+            }
+            const size_t produced = out.size() - stream.avail_out;
+            // nothing past the declared size reaches _rwrite_fnc
+            if (size + produced > _rentry.size_) {
+                inflateEnd(&stream);
+                solid_log(logger, Error, "Size mismatch for " << _rentry.name_);
+                return false;
+            }
+            crc = crc32_update(crc, out.data(), produced);
+            size += produced;
+            if (produced != 0 && !_rwrite_fnc(out.data(), produced)) {
+                inflateEnd(&stream);
+                return false;
+            }
+        }
+        inflateEnd(&stream);
+        if (rv != Z_STREAM_END) {
+            solid_log(logger, Error, "Inflate failed for " << _rentry.name_);
+            return false;
+        }
+    } else {
+        solid_log(logger, Error, "Unsupported compression method " << _rentry.method_ << " for " << _rentry.name_);
+        return false;
+    }
+
+    if (size != _rentry.size_ || crc != _rentry.crc_) {
+        solid_log(logger, Error, "Size or CRC mismatch for " << _rentry.name_);
+        return false;
+    }
+    return true;
+}
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
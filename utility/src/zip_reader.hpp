@@ -0,0 +1,49 @@
+// myapps/common/utility/src/zip_reader.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "myapps/common/utility/archive.hpp"
+#include "myapps/common/utility/archive_reader.hpp"
+#include "zip_file.hpp"
+#include <string>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+namespace zip {
+
+constexpr size_t read_buffer_size = 64 * 1024;
+
+// Central directory parser (zip64 aware) and entry readers over a positional read File.
+
+bool read_central_directory(const File& _rfile, std::vector<ArchiveEntry>& _rentries);
+
+// offset of the entry data, and optionally the meta extra field, from the local header;
+// with _strict, an extra field running past the end of the extra block is an error
+bool read_local_header(const File& _rfile, const ArchiveEntry& _rentry, uint64_t& _rdata_offset, std::vector<uint8_t>* _pmeta = nullptr, bool _strict = false);
+
+// at most _len bytes of uncompressed content starting at _offset
+bool read_entry(const File& _rfile, const ArchiveEntry& _rentry, uint64_t _offset, uint64_t _len, std::string& _rdata);
+
+// the whole uncompressed content, data located at _data_offset, through _rwrite_fnc in
+// read_buffer_size pieces; the size and crc are checked at the end
+bool read_entry(const File& _rfile, const ArchiveEntry& _rentry, uint64_t _data_offset, const FileWriteFunctionT& _rwrite_fnc);
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,270 @@
+// myapps/common/utility/src/zip_writer.cpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "zip_writer.hpp"
+#include "zip_format.hpp"
+
+using namespace std;
+
+namespace myapps {
+namespace utility {
+namespace zip {
+namespace {
+// leave room for deflate expansion when deciding on zip64 before the data is known
+constexpr uint64_t zip64_size_threshold = 0xf0000000ULL;
+constexpr uint32_t file_external_attr   = 0100644U << 16;
+constexpr uint32_t dir_external_attr    = (040755U << 16) | 0x10;
+} // namespace
+
+Writer::Writer(WriteFunctionT&& _write_fnc)
+    : write_fnc_(std::move(_write_fnc))
+{
+}
+
+bool Writer::flush(const std::string& _buf)
+{
+    if (!write_fnc_(_buf.data(), _buf.size())) {
+        return false;
+    }
+    offset_ += _buf.size();
+    return true;
+}
+
+bool Writer::addDirectory(const std::string& _name, const time_t _mtime)
+{
+    if (in_file_) {
+        return false;
+    }
+    Entry entry;
+    entry.name_          = _name;
+    entry.date_time_     = dos_date_time(_mtime);
+    entry.method_        = method_store;
+    entry.flags_         = flag_utf8;
+    entry.local_offset_  = offset_;
+    entry.external_attr_ = dir_external_attr;
+
+    buf_.clear();
+    store_u32(buf_, local_file_header_signature);
+    store_u16(buf_, version_default);
+    store_u16(buf_, entry.flags_);
+    store_u16(buf_, entry.method_);
+    store_u32(buf_, entry.date_time_);
+    store_u32(buf_, 0); // crc
+    store_u32(buf_, 0); // compressed size
+    store_u32(buf_, 0); // uncompressed size
+    store_u16(buf_, static_cast<uint16_t>(_name.size()));
+    store_u16(buf_, 0);
+    buf_ += _name;
+
+    if (!flush(buf_)) {
+        return false;
+    }
+    entries_.emplace_back(std::move(entry));
+    return true;
+}
+
+bool Writer::beginFile(
+    const std::string& _name, const time_t _mtime, const uint16_t _method, const uint64_t _size_hint,
+    const uint8_t* _meta_data, const size_t _meta_size)
+{
+    if (in_file_ || _name.size() > max_u16 || _meta_size > max_meta_size) {
+        return false;
+    }
+    Entry entry;
+    entry.name_          = _name;
+    entry.date_time_     = dos_date_time(_mtime);
+    entry.method_        = _method;
+    entry.flags_         = flag_utf8 | flag_data_descriptor;
+    entry.local_offset_  = offset_;
+    entry.external_attr_ = file_external_attr;
+    entry.zip64_local_   = _size_hint >= zip64_size_threshold;
+
+    uint16_t extra_size = 4 + 8;
+    if (entry.zip64_local_) {
+        extra_size += 4 + 16;
+    }
+    if (_meta_size != 0) {
+        extra_size += static_cast<uint16_t>(4 + _meta_size);
+    }
+
+    buf_.clear();
+    store_u32(buf_, local_file_header_signature);
+    store_u16(buf_, entry.zip64_local_ ? version_zip64 : version_default);
+    store_u16(buf_, entry.flags_);
+    store_u16(buf_, entry.method_);
+    store_u32(buf_, entry.date_time_);
+    store_u32(buf_, 0); // crc - in data descriptor
+    store_u32(buf_, entry.zip64_local_ ? max_u32 : 0);
+    store_u32(buf_, entry.zip64_local_ ? max_u32 : 0);
+    store_u16(buf_, static_cast<uint16_t>(_name.size()));
+    store_u16(buf_, extra_size);
+    buf_ += _name;
+    if (entry.zip64_local_) {
+        store_u16(buf_, zip64_extra_field_id);
+        store_u16(buf_, 16);
+        store_u64(buf_, 0);
+        store_u64(buf_, 0);
+    }
+    store_u16(buf_, size_extra_field_id);
+    store_u16(buf_, 8);
+    store_u64(buf_, _size_hint);
+    if (_meta_size != 0) {
+        store_u16(buf_, meta_extra_field_id);
+        store_u16(buf_, static_cast<uint16_t>(_meta_size));
+        buf_.append(reinterpret_cast<const char*>(_meta_data), _meta_size);
+    }
+
+    if (!flush(buf_)) {
+        return false;
+    }
+    entries_.emplace_back(std::move(entry));
+    in_file_ = true;
+    return true;
+}
+
+bool Writer::write(const char* _data, const size_t _size)
+{
+    if (!in_file_) {
+        return false;
+    }
+    if (_size == 0) {
+        return true;
+    }
+    if (!write_fnc_(_data, _size)) {
+        return false;
+    }
+    offset_ += _size;
+    entries_.back().compressed_size_ += _size;
+    return true;
+}
+
+bool Writer::endFile(const uint32_t _crc, const uint64_t _size)
+{
+    if (!in_file_) {
+        return false;
+    }
+    in_file_     = false;
+    Entry& entry = entries_.back();
+
+    entry.crc_               = _crc;
+    entry.uncompressed_size_ = _size;
+
+    if (!entry.zip64_local_ && (entry.compressed_size_ >= max_u32 || entry.uncompressed_size_ >= max_u32)) {
+        // the local header promised 32 bit sizes
+        return false;
+    }
+
+    buf_.clear();
+    store_u32(buf_, data_descriptor_signature);
+    store_u32(buf_, entry.crc_);
+    if (entry.zip64_local_) {
+        store_u64(buf_, entry.compressed_size_);
+        store_u64(buf_, entry.uncompressed_size_);
+    } else {
+        store_u32(buf_, static_cast<uint32_t>(entry.compressed_size_));
+        store_u32(buf_, static_cast<uint32_t>(entry.uncompressed_size_));
+    }
+    return flush(buf_);
+}
+
+bool Writer::finish()
+{
+    if (in_file_) {
+        return false;
+    }
+    const uint64_t central_offset = offset_;
+
+    for (const auto& entry : entries_) {
+        string zip64_extra;
+        if (entry.uncompressed_size_ >= max_u32) {
+            store_u64(zip64_extra, entry.uncompressed_size_);
+        }
+        if (entry.compressed_size_ >= max_u32) {
+            store_u64(zip64_extra, entry.compressed_size_);
+        }
+        if (entry.local_offset_ >= max_u32) {
+            store_u64(zip64_extra, entry.local_offset_);
+        }
+        const bool     zip64   = !zip64_extra.empty() || entry.zip64_local_;
+        const uint16_t version = zip64 ? version_zip64 : version_default;
+
+        buf_.clear();
+        store_u32(buf_, central_file_header_signature);
+        store_u16(buf_, made_by_unix | version);
+        store_u16(buf_, version);
+        store_u16(buf_, entry.flags_);
+        store_u16(buf_, entry.method_);
+        store_u32(buf_, entry.date_time_);
+        store_u32(buf_, entry.crc_);
+        store_u32(buf_, entry.compressed_size_ >= max_u32 ? max_u32 : static_cast<uint32_t>(entry.compressed_size_));
+        store_u32(buf_, entry.uncompressed_size_ >= max_u32 ? max_u32 : static_cast<uint32_t>(entry.uncompressed_size_));
+        store_u16(buf_, static_cast<uint16_t>(entry.name_.size()));
+        store_u16(buf_, static_cast<uint16_t>(zip64_extra.empty() ? 0 : zip64_extra.size() + 4));
+        store_u16(buf_, 0); // comment
+        store_u16(buf_, 0); // disk number
+        store_u16(buf_, 0); // internal attributes
+        store_u32(buf_, entry.external_attr_);
+        store_u32(buf_, entry.local_offset_ >= max_u32 ? max_u32 : static_cast<uint32_t>(entry.local_offset_));
+        buf_ += entry.name_;
+        if (!zip64_extra.empty()) {
+            store_u16(buf_, zip64_extra_field_id);
+            store_u16(buf_, static_cast<uint16_t>(zip64_extra.size()));
+            buf_ += zip64_extra;
+        }
+        if (!flush(buf_)) {
+            return false;
+        }
+    }
+
+    const uint64_t central_size = offset_ - central_offset;
+    const bool     zip64        = entries_.size() >= max_u16 || central_offset >= max_u32 || central_size >= max_u32;
+
+    buf_.clear();
+    if (zip64) {
+        const uint64_t zip64_end_offset = offset_;
+        store_u32(buf_, zip64_end_of_central_signature);
+        store_u64(buf_, zip64_end_of_central_size - 12);
+        store_u16(buf_, made_by_unix | version_zip64);
+        store_u16(buf_, version_zip64);
+        store_u32(buf_, 0); // this disk
+        store_u32(buf_, 0); // central directory disk
+        store_u64(buf_, entries_.size());
+        store_u64(buf_, entries_.size());
+        store_u64(buf_, central_size);
+        store_u64(buf_, central_offset);
+
+        store_u32(buf_, zip64_locator_signature);
+        store_u32(buf_, 0);
+        store_u64(buf_, zip64_end_offset);
+        store_u32(buf_, 1);
+    }
+    store_u32(buf_, end_of_central_signature);
+    store_u16(buf_, 0);
+    store_u16(buf_, 0);
+    store_u16(buf_, zip64 ? max_u16 : static_cast<uint16_t>(entries_.size()));
+    store_u16(buf_, zip64 ? max_u16 : static_cast<uint16_t>(entries_.size()));
+    store_u32(buf_, zip64 ? max_u32 : static_cast<uint32_t>(central_size));
+    store_u32(buf_, zip64 ? max_u32 : static_cast<uint32_t>(central_offset));
+    store_u16(buf_, 0); // comment
+
+    return flush(buf_);
+}
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
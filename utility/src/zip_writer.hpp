@@ -0,0 +1,81 @@
+// myapps/common/utility/src/zip_writer.hpp
+
+// This file is part of MyApps.directory project
+// Copyright (C) 2020, 2021, 2022, 2023, 2024, 2025 Valentin Palade (vipalade @ gmail . com)
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+#include "solid/utility/function.hpp"
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace myapps {
+namespace utility {
+namespace zip {
+
+// Sequential zip writer: every byte goes out through the write function exactly once,
+// in order, so the target does not need to be seekable.
+// File entries use a data descriptor (general purpose bit 3) because their CRC and
+// compressed size are only known after the data was written.
+class Writer {
+public:
+    using WriteFunctionT = solid::Function<bool(const char*, size_t)>;
+
+    explicit Writer(WriteFunctionT&& _write_fnc);
+
+    bool addDirectory(const std::string& _name, time_t _mtime);
+
+    // _size_hint is the expected uncompressed size; it selects the zip64 layout upfront
+    // and is recorded in the local header (size_extra_field_id) for streaming readers
+    bool beginFile(
+        const std::string& _name, time_t _mtime, uint16_t _method, uint64_t _size_hint,
+        const uint8_t* _meta_data, size_t _meta_size);
+    // already compressed (or stored) entry bytes
+    bool write(const char* _data, size_t _size);
+    bool endFile(uint32_t _crc, uint64_t _size);
+
+    bool finish();
+
+    uint64_t offset() const { return offset_; }
+
+private:
+    struct Entry {
+        std::string name_;
+        uint32_t    date_time_         = 0;
+        uint16_t    method_            = 0;
+        uint16_t    flags_             = 0;
+        uint32_t    crc_               = 0;
+        uint64_t    compressed_size_   = 0;
+        uint64_t    uncompressed_size_ = 0;
+        uint64_t    local_offset_      = 0;
+        uint32_t    external_attr_     = 0;
+        bool        zip64_local_       = false;
+    };
+
+    bool flush(const std::string& _buf);
+
+private:
+    WriteFunctionT     write_fnc_;
+    uint64_t           offset_ = 0;
+    std::vector<Entry> entries_;
+    bool               in_file_ = false;
+    std::string        buf_;
+};
+
+} // namespace zip
+} // namespace utility
+} // namespace myapps
@@ -0,0 +1,189 @@
+#pragma once
+#include "solid/system/exception.hpp"
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// the source tree the archive tests share; every test builds its own copy under its own name
+namespace archive_fixture {
+
+inline const std::string& pattern()
+{
+    static const std::string pattern = []() {
+        std::string s;
+        for (int j = 0; s.size() < 4 * 1024; ++j) {
+            for (int i = 0; i < 127; ++i) {
+                int c = (i + j) % 127;
+                if (isprint(c) != 0 && isblank(c) == 0) {
+                    s += static_cast<char>(c);
+                }
+            }
+        }
+        return s;
+    }();
+    return pattern;
+}
+
+inline void create_file(const std::string& _path, size_t _size)
+{
+    std::ofstream ofs(_path, std::ifstream::binary);
+
+    while (_size) {
+        size_t towrite = _size;
+        if (towrite > pattern().size()) {
+            towrite = pattern().size();
+        }
+        ofs.write(pattern().c_str(), towrite);
+        _size -= towrite;
+    }
+}
+
+inline void create_files(const std::string& _root, size_t _count, size_t _max_size)
+{
+    for (size_t i = 0; i < _count; ++i) {
+        std::ostringstream oss;
+        oss << _root << "/" << std::hex << std::setw(4) << std::setfill('0') << i;
+        create_file(oss.str(), i % _max_size);
+    }
+}
+
+// the name of the i-th file of a directory of the tree, _dir is empty or ends with '/'
+inline std::string file_name(const std::string& _dir, size_t _index)
+{
+    std::ostringstream oss;
+    oss << _dir << std::hex << std::setw(4) << std::setfill('0') << _index;
+    return oss.str();
+}
+
+inline void remove_all(std::initializer_list<std::string> _paths)
+{
+    boost::system::error_code err;
+    for (const auto& path : _paths) {
+        boost::filesystem::remove_all(path, err);
+    }
+}
+
+// "", first/, second/ and second/third/, each with 100 files of 0 to 99 bytes
+inline void create_tree(const std::string& _root)
+{
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    fs::path                  root_path(_root);
+
+    fs::remove_all(root_path, err);
+    solid_check(fs::create_directory(root_path, err));
+    create_files(_root, 100, 4 * 1024);
+    solid_check(fs::create_directory(root_path / "first", err));
+    create_files((root_path / "first").generic_string(), 100, 4 * 1024);
+    solid_check(fs::create_directory(root_path / "second", err));
+    create_files((root_path / "second").generic_string(), 100, 4 * 1024);
+    solid_check(fs::create_directory(root_path / "second" / "third", err));
+    create_files((root_path / "second" / "third").generic_string(), 100, 4 * 1024);
+}
+
+constexpr uint64_t tree_size = 4 * (99 * 100 / 2);
+
+// little endian _value on _bytes bytes, for the hand made archives below
+inline void store(std::string& _rdata, uint64_t _value, size_t _bytes)
+{
+    for (size_t i = 0; i < _bytes; ++i) {
+        _rdata += static_cast<char>((_value >> (8 * i)) & 0xff);
+    }
+}
+
+// an archive made only of zip64 end records claiming _count entries in _size bytes at _offset
+inline void create_zip64_end(const std::string& _path, uint64_t _count, uint64_t _size, uint64_t _offset)
+{
+    std::string data;
+    // zip64 end of central directory record
+    store(data, 0x06064b50, 4);
+    store(data, 44, 8);
+    store(data, 45, 2);
+    store(data, 45, 2);
+    store(data, 0, 4);
+    store(data, 0, 4);
+    store(data, _count, 8);
+    store(data, _count, 8);
+    store(data, _size, 8);
+    store(data, _offset, 8);
+    // zip64 end of central directory locator
+    store(data, 0x07064b50, 4);
+    store(data, 0, 4);
+    store(data, 0, 8);
+    store(data, 1, 4);
+    // end of central directory record deferring to the zip64 one
+    store(data, 0x06054b50, 4);
+    store(data, 0, 2);
+    store(data, 0, 2);
+    store(data, 0xffff, 2);
+    store(data, 0xffff, 2);
+    store(data, 0xffffffff, 4);
+    store(data, 0xffffffff, 4);
+    store(data, 0, 2);
+
+    std::ofstream ofs(_path, std::ofstream::binary);
+    ofs.write(data.data(), data.size());
+}
+
+// an archive of stored entries (name, content) written as is, whatever the names
+inline void create_stored_zip(const std::string& _path, const std::vector<std::pair<std::string, std::string>>& _entries)
+{
+    std::string data;
+    std::string central;
+    for (const auto& entry : _entries) {
+        boost::crc_32_type crc;
+        crc.process_bytes(entry.second.data(), entry.second.size());
+
+        const uint64_t local_offset = data.size();
+        for (std::string* pdata : {&data, &central}) {
+            const bool is_central = pdata == &central;
+            store(*pdata, is_central ? 0x02014b50 : 0x04034b50, 4);
+            if (is_central) {
+                store(*pdata, 20, 2);
+            }
+            store(*pdata, 20, 2);
+            store(*pdata, 0, 2);
+            store(*pdata, 0, 2);
+            store(*pdata, 0, 2);
+            store(*pdata, 0x21, 2); // 1980-01-01
+            store(*pdata, crc.checksum(), 4);
+            store(*pdata, entry.second.size(), 4);
+            store(*pdata, entry.second.size(), 4);
+            store(*pdata, entry.first.size(), 2);
+            store(*pdata, 0, 2);
+            if (is_central) {
+                store(*pdata, 0, 2);
+                store(*pdata, 0, 2);
+                store(*pdata, 0, 2);
+                store(*pdata, 0, 4);
+                store(*pdata, local_offset, 4);
+            }
+            *pdata += entry.first;
+        }
+        data += entry.second;
+    }
+    const uint64_t central_offset = data.size();
+    data += central;
+    store(data, 0x06054b50, 4);
+    store(data, 0, 2);
+    store(data, 0, 2);
+    store(data, _entries.size(), 2);
+    store(data, _entries.size(), 2);
+    store(data, central.size(), 4);
+    store(data, central_offset, 4);
+    store(data, 0, 2);
+
+    std::ofstream ofs(_path, std::ofstream::binary);
+    ofs.write(data.data(), data.size());
+}
+
+} // namespace archive_fixture
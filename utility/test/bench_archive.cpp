@@ -0,0 +1,352 @@
+#include "myapps/common/utility/archive.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+// Archive create/extract benchmark over synthetic trees.
+// Usage: bench_myapps_utility [--workload tiny|huge|random|deep|all] [--scale N] [--workers N]
+//                             [--solid BYTES] [--dir PATH] [--output PATH] [--keep]
+// Each measured phase is written as one JSON object per line.
+
+namespace {
+
+struct Options {
+    string   workload_ = "all";
+    double   scale_    = 1.0;
+    size_t   workers_  = 0;
+    uint64_t solid_    = 0;
+    string   dir_      = "bench_archive";
+    string   output_;
+    bool     keep_     = false;
+};
+
+struct Tree {
+    uint64_t file_count_ = 0;
+    uint64_t dir_count_  = 0;
+    uint64_t size_       = 0;
+};
+
+// Samples the resident set and the open file descriptors while a phase runs.
+// Only implemented on Linux (/proc/self), elsewhere the peaks stay 0.
+class ResourceSampler {
+    mutex              mutex_;
+    condition_variable cnd_;
+    bool               running_  = true;
+    uint64_t           peak_rss_ = 0;
+    uint64_t           peak_fds_ = 0;
+    thread             thread_;
+
+    static uint64_t rss()
+    {
+#ifdef __linux__
+        ifstream ifs("/proc/self/statm");
+        uint64_t size = 0, resident = 0;
+        ifs >> size >> resident;
+        return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    static uint64_t fds()
+    {
+#ifdef __linux__
+        boost::system::error_code err;
+        uint64_t                  count = 0;
+        for (fs::directory_iterator it("/proc/self/fd", err), end; !err && it != end; it.increment(err)) {
+            ++count;
+        }
+        return count;
+#else
+        return 0;
+#endif
+    }
+
+    void sample()
+    {
+        peak_rss_ = std::max(peak_rss_, rss());
+        peak_fds_ = std::max(peak_fds_, fds());
+    }
+
+public:
+    ResourceSampler()
+    {
+        sample();
+        thread_ = thread([this]() {
+            unique_lock<mutex> lock(mutex_);
+            while (running_) {
+                sample();
+                cnd_.wait_for(lock, chrono::milliseconds(2));
+            }
+        });
+    }
+
+    void stop()
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            running_ = false;
+            sample();
+        }
+        cnd_.notify_one();
+        thread_.join();
+    }
+
+    uint64_t peakRss() const { return peak_rss_; }
+    uint64_t peakFds() const { return peak_fds_; }
+};
+
+void write_file(const string& _path, uint64_t _size, mt19937_64& _rgen, const bool _random, Tree& _rtree)
+{
+    static const string words[] = {"archive ", "entry ", "deflate ", "block ", "myapps ", "directory ", "build ", "media\n"};
+
+    constexpr size_t buffer_size = 64 * 1024;
+
+    ofstream ofs(_path, ios::binary);
+    string   buf;
+    uint64_t remaining = _size;
+    while (remaining != 0) {
+        buf.clear();
+        if (_random) {
+            while (buf.size() < buffer_size) {
+                const uint64_t value = _rgen();
+                buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+        } else {
+            while (buf.size() < buffer_size) {
+                buf += words[_rgen() % 8];
+            }
+        }
+        const size_t len = static_cast<size_t>(std::min<uint64_t>(remaining, buf.size()));
+        ofs.write(buf.data(), len);
+        remaining -= len;
+    }
+    ++_rtree.file_count_;
+    _rtree.size_ += _size;
+}
+
+uint64_t scaled(const uint64_t _value, const double _scale)
+{
+    return std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(_value) * _scale));
+}
+
+// many tiny files, 0 - 1KB, 256 per directory
+Tree build_tiny(const string& _root, const double _scale)
+{
+    Tree       tree;
+    mt19937_64 rgen(1);
+    const auto count = scaled(20000, _scale);
+    for (uint64_t i = 0; i < count; ++i) {
+        ostringstream oss;
+        oss << _root << '/' << hex << setw(4) << setfill('0') << (i / 256);
+        if (i % 256 == 0) {
+            fs::create_directory(oss.str());
+            ++tree.dir_count_;
+        }
+        oss << '/' << setw(4) << setfill('0') << i;
+        write_file(oss.str(), rgen() % 1024, rgen, false, tree);
+    }
+    return tree;
+}
+
+// few huge compressible files
+Tree build_huge(const string& _root, const double _scale)
+{
+    Tree       tree;
+    mt19937_64 rgen(2);
+    for (int i = 0; i < 4; ++i) {
+        write_file(_root + "/huge_" + to_string(i), scaled(64 * 1024 * 1024, _scale), rgen, false, tree);
+    }
+    return tree;
+}
+
+// incompressible data, mixed sizes
+Tree build_random(const string& _root, const double _scale)
+{
+    Tree       tree;
+    mt19937_64 rgen(3);
+    const auto count = scaled(64, _scale);
+    for (uint64_t i = 0; i < count; ++i) {
+        write_file(_root + "/random_" + to_string(i) + ".bin", (i % 2) ? 4 * 1024 * 1024 : 16 * 1024 + i, rgen, true, tree);
+    }
+    return tree;
+}
+
+// deep nesting: chains of 48 directories with a small file on every level
+Tree build_deep(const string& _root, const double _scale)
+{
+    Tree       tree;
+    mt19937_64 rgen(4);
+    const auto chains = scaled(32, _scale);
+    for (uint64_t c = 0; c < chains; ++c) {
+        string path = _root + "/chain_" + to_string(c);
+        for (int level = 0; level < 48; ++level) {
+            fs::create_directory(path);
+            ++tree.dir_count_;
+            write_file(path + "/file", 512 + rgen() % 4096, rgen, false, tree);
+            path += "/d" + to_string(level);
+        }
+    }
+    return tree;
+}
+
+struct Workload {
+    const char* name_;
+    Tree (*build_fnc_)(const string&, double);
+};
+
+const Workload workloads[] = {
+    {"tiny", build_tiny},
+    {"huge", build_huge},
+    {"random", build_random},
+    {"deep", build_deep},
+};
+
+void report(
+    ostream& _ros, const Options& _options, const char* _workload, const char* _phase, const Tree& _tree,
+    const bool _ok, const double _seconds, const uint64_t _archive_size, const ResourceSampler& _sampler)
+{
+    const double mbps = _seconds > 0 ? static_cast<double>(_tree.size_) / (1024.0 * 1024.0) / _seconds : 0.0;
+    _ros << "{\"workload\":\"" << _workload << "\",\"phase\":\"" << _phase << "\",\"ok\":" << (_ok ? "true" : "false")
+         << ",\"scale\":" << _options.scale_ << ",\"workers\":" << _options.workers_ << ",\"solid\":" << _options.solid_
+         << ",\"files\":" << _tree.file_count_ << ",\"dirs\":" << _tree.dir_count_ << ",\"bytes\":" << _tree.size_
+         << ",\"archive_bytes\":" << _archive_size << ",\"seconds\":" << fixed << setprecision(6) << _seconds
+         << ",\"mb_per_s\":" << setprecision(2) << mbps << defaultfloat
+         << ",\"peak_rss\":" << _sampler.peakRss() << ",\"peak_fds\":" << _sampler.peakFds() << '}' << endl;
+}
+
+bool run(ostream& _ros, const Options& _options, const Workload& _workload)
+{
+    boost::system::error_code err;
+    const string              base    = _options.dir_ + '/' + _workload.name_;
+    const string              root    = base + "/root";
+    const string              zip     = base + "/archive.zip";
+    const string              extract = base + "/extract";
+
+    fs::remove_all(base, err);
+    fs::create_directories(root, err);
+    if (err) {
+        cerr << "cannot create " << root << ": " << err.message() << endl;
+        return false;
+    }
+
+    const Tree tree = _workload.build_fnc_(root, _options.scale_);
+
+    myapps::utility::ArchiveCreateOptions create_options;
+    create_options.worker_count_    = _options.workers_;
+    create_options.solid_file_size_ = _options.solid_;
+
+    bool ok = false;
+    {
+        uint64_t        size = 0;
+        ResourceSampler sampler;
+        const auto      start = chrono::steady_clock::now();
+        ok                    = myapps::utility::archive_create(zip, root, size, create_options);
+        const auto stop       = chrono::steady_clock::now();
+        sampler.stop();
+        ok = ok && size == tree.size_;
+        report(_ros, _options, _workload.name_, "create", tree, ok, chrono::duration<double>(stop - start).count(), fs::file_size(zip, err), sampler);
+    }
+    if (ok) {
+        myapps::utility::ArchiveExtractOptions extract_options;
+        extract_options.worker_count_ = _options.workers_;
+
+        uint64_t size = 0;
+        fs::create_directory(extract, err);
+        ResourceSampler sampler;
+        const auto      start = chrono::steady_clock::now();
+        ok                    = myapps::utility::archive_extract(zip, extract, size, extract_options);
+        const auto stop       = chrono::steady_clock::now();
+        sampler.stop();
+        ok = ok && size == tree.size_;
+        report(_ros, _options, _workload.name_, "extract", tree, ok, chrono::duration<double>(stop - start).count(), fs::file_size(zip, err), sampler);
+    }
+    if (!_options.keep_) {
+        fs::remove_all(base, err);
+    }
+    return ok;
+}
+
+bool parse(int argc, char* argv[], Options& _roptions)
+{
+    for (int i = 1; i < argc; ++i) {
+        const string arg   = argv[i];
+        const char*  value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--keep") {
+            _roptions.keep_ = true;
+            continue;
+        }
+        if (value == nullptr) {
+            return false;
+        }
+        ++i;
+        if (arg == "--workload") {
+            _roptions.workload_ = value;
+        } else if (arg == "--scale") {
+            _roptions.scale_ = stod(value);
+        } else if (arg == "--workers") {
+            _roptions.workers_ = stoul(value);
+        } else if (arg == "--solid") {
+            _roptions.solid_ = stoull(value);
+        } else if (arg == "--dir") {
+            _roptions.dir_ = value;
+        } else if (arg == "--output") {
+            _roptions.output_ = value;
+        } else {
+            return false;
+        }
+    }
+    return _roptions.scale_ > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+
+    Options options;
+    if (!parse(argc, argv, options)) {
+        cerr << "usage: " << argv[0] << " [--workload tiny|huge|random|deep|all] [--scale N] [--workers N] [--solid BYTES] [--dir PATH] [--output PATH] [--keep]" << endl;
+        return 1;
+    }
+
+    ofstream ofs;
+    if (!options.output_.empty()) {
+        ofs.open(options.output_, ios::app);
+        if (!ofs) {
+            cerr << "cannot open " << options.output_ << endl;
+            return 1;
+        }
+    }
+    ostream& os = options.output_.empty() ? cout : ofs;
+
+    bool found = false;
+    bool ok    = true;
+    for (const auto& workload : workloads) {
+        if (options.workload_ == "all" || options.workload_ == workload.name_) {
+            found = true;
+            ok    = run(os, options, workload) && ok;
+        }
+    }
+    if (!found) {
+        cerr << "unknown workload: " << options.workload_ << endl;
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
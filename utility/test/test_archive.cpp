@@ -1,11 +1,10 @@
+#include "archive_fixture.hpp"
 #include "myapps/common/utility/archive.hpp"
 #include "solid/system/exception.hpp"
 #include "solid/system/log.hpp"
 #include <boost/filesystem.hpp>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
 
 using namespace std;
 
@@ -13,30 +12,8 @@ namespace {
 const string archive_root    = "test_archive_root";
 const string archive_path    = "test_archive.zip";
 const string archive_extract = "test_archive_extract";
-string       pattern;
-
-void create_file(const string& _path, size_t _size)
-{
-    ofstream ofs(_path, std::ifstream::binary);
-
-    while (_size) {
-        size_t towrite = _size;
-        if (towrite > pattern.size()) {
-            towrite = pattern.size();
-        }
-        ofs.write(pattern.c_str(), towrite);
-        _size -= towrite;
-    }
-}
-
-void create_files(const string& _root, size_t _count, size_t _max_size)
-{
-    for (size_t i = 0; i < _count; ++i) {
-        ostringstream oss;
-        oss << _root << "/" << hex << setw(4) << setfill('0') << i;
-        create_file(oss.str(), i % _max_size);
-    }
-}
+const string archive_copy    = "test_archive_copy_extract";
+const string archive_sync    = "test_archive_sync_extract";
 } // namespace
 
 int test_archive(int argc, char* argv[])
@@ -45,29 +22,8 @@ int test_archive(int argc, char* argv[])
     namespace fs = boost::filesystem;
 
     boost::system::error_code err;
-    fs::remove_all(archive_root, err);
-    fs::remove_all(archive_path, err);
-    fs::remove_all(archive_extract, err);
-
-    for (int j = 0; pattern.size() < 4 * 1024; ++j) {
-        for (int i = 0; i < 127; ++i) {
-            int c = (i + j) % 127;
-            if (isprint(c) != 0 && isblank(c) == 0) {
-                pattern += static_cast<char>(c);
-            }
-        }
-    }
-
-    fs::path archive_root_path(archive_root);
-
-    solid_check(fs::create_directory(archive_root_path, err));
-    create_files(archive_root, 100, 4 * 1024);
-    solid_check(fs::create_directory(archive_root_path / "first", err));
-    create_files((archive_root_path / "first").generic_string(), 100, 4 * 1024);
-    solid_check(fs::create_directory(archive_root_path / "second", err));
-    create_files((archive_root_path / "second").generic_string(), 100, 4 * 1024);
-    solid_check(fs::create_directory(archive_root_path / "second" / "third", err));
-    create_files((archive_root_path / "second" / "third").generic_string(), 100, 4 * 1024);
+    archive_fixture::remove_all({archive_root, archive_path, archive_extract, archive_copy, archive_sync});
+    archive_fixture::create_tree(archive_root);
 
     uint64_t create_total_size = 0;
     solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
@@ -75,6 +31,49 @@ int test_archive(int argc, char* argv[])
     uint64_t extract_total_size = 0;
     solid_check(fs::create_directory(archive_extract, err));
     solid_check(myapps::utility::archive_extract(archive_path, archive_extract, extract_total_size));
-    solid_check(create_total_size == extract_total_size && extract_total_size != 0);
+    solid_check(create_total_size == extract_total_size && extract_total_size == archive_fixture::tree_size);
+
+    myapps::utility::ArchiveExtractOptions copy_options;
+    copy_options.zero_copy_ = true;
+
+    uint64_t copy_total_size = 0;
+    solid_check(fs::create_directory(archive_copy, err));
+    solid_check(myapps::utility::archive_extract(archive_path, archive_copy, copy_total_size, copy_options));
+    solid_check(copy_total_size == create_total_size && fs::file_size(fs::path(archive_copy) / "second" / "third" / "0063") == 99);
+
+    // a durable extraction writes the same tree, serially and with workers
+    for (const size_t worker_count : {0, 4}) {
+        myapps::utility::ArchiveExtractOptions sync_options;
+        sync_options.sync_         = true;
+        sync_options.worker_count_ = worker_count;
+
+        uint64_t sync_total_size = 0;
+        fs::remove_all(archive_sync, err);
+        solid_check(fs::create_directory(archive_sync, err));
+        solid_check(myapps::utility::archive_extract(archive_path, archive_sync, sync_total_size, sync_options));
+        solid_check(sync_total_size == create_total_size);
+        for (const char* dir : {"", "first/", "second/", "second/third/"}) {
+            for (size_t i = 0; i < 100; ++i) {
+                solid_check(fs::file_size(fs::path(archive_sync) / archive_fixture::file_name(dir, i)) == i);
+            }
+        }
+        ifstream ifs((fs::path(archive_sync) / "first" / "0063").generic_string(), ios::binary);
+        string   data((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+        solid_check(data == archive_fixture::pattern().substr(0, 99));
+    }
+    // only the directories holding the filtered entries are created, so only they are synced
+    for (const size_t worker_count : {0, 3}) {
+        myapps::utility::ArchiveExtractOptions sync_options;
+        sync_options.sync_             = true;
+        sync_options.worker_count_     = worker_count;
+        sync_options.filter_.patterns_ = {"second/third/0063"};
+
+        uint64_t sync_total_size = 0;
+        fs::remove_all(archive_sync, err);
+        solid_check(fs::create_directory(archive_sync, err));
+        solid_check(myapps::utility::archive_extract(archive_path, archive_sync, sync_total_size, sync_options));
+        solid_check(sync_total_size == 99 && fs::file_size(fs::path(archive_sync) / "second" / "third" / "0063") == 99);
+        solid_check(!fs::exists(fs::path(archive_sync) / "first") && !fs::exists(fs::path(archive_sync) / "second" / "0063"));
+    }
     return 0;
 }
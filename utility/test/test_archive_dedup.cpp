@@ -0,0 +1,78 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const string archive_root          = "test_archive_dedup_root";
+const string archive_path          = "test_archive_dedup_plain.zip";
+const string archive_dedup_path    = "test_archive_dedup.zip";
+const string archive_dedup_extract = "test_archive_dedup_extract";
+const string archive_bad_path      = "test_archive_dedup_bad.zip";
+} // namespace
+
+int test_archive_dedup(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    archive_fixture::remove_all({archive_root, archive_path, archive_dedup_path, archive_dedup_extract, archive_bad_path});
+    archive_fixture::create_tree(archive_root);
+
+    uint64_t create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+
+    // the 4 directories hold the same files: 3 * 99 non-empty ones are stored as aliases
+    myapps::utility::ArchiveCreateOptions dedup_options;
+    dedup_options.deduplicate_    = true;
+    dedup_options.write_manifest_ = true;
+
+    uint64_t dedup_create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_dedup_path, archive_root, dedup_create_total_size, dedup_options));
+    solid_check(dedup_create_total_size == create_total_size && fs::file_size(archive_dedup_path) < fs::file_size(archive_path));
+
+    std::vector<myapps::utility::ArchiveListEntry> list;
+    solid_check(myapps::utility::archive_list(archive_dedup_path, list) && list.size() == 403);
+
+    myapps::utility::ArchiveVerifyResult verify_result;
+    solid_check(myapps::utility::archive_verify(archive_dedup_path, verify_result) && verify_result.entry_count_ == 403 - 297 + 2);
+
+    myapps::utility::ArchiveExtractOptions dedup_extract_options;
+    dedup_extract_options.hardlink_aliases_ = true;
+
+    uint64_t dedup_extract_total_size = 0;
+    solid_check(fs::create_directory(archive_dedup_extract, err));
+    solid_check(myapps::utility::archive_extract(archive_dedup_path, archive_dedup_extract, dedup_extract_total_size, dedup_extract_options));
+    solid_check(dedup_extract_total_size == create_total_size);
+
+    const fs::path alias_path = fs::path(archive_dedup_extract) / "second" / "third" / "0063";
+    solid_check(fs::file_size(alias_path) == 99 && fs::hard_link_count(alias_path) == 4);
+
+    {
+        // aliases and solid members regroup the files: their metas still come in name order
+        myapps::utility::ArchiveCreateOptions solid_options = dedup_options;
+        solid_options.solid_file_size_                      = 64;
+
+        vector<string> meta_names;
+        uint64_t       solid_create_total_size = 0;
+        solid_check(myapps::utility::archive_create(archive_bad_path, archive_root, solid_create_total_size, solid_options, [&meta_names](const string& _path, vector<uint8_t>&) {
+            meta_names.emplace_back(_path);
+        }));
+        solid_check(meta_names.size() == 400 && std::is_sorted(meta_names.begin(), meta_names.end()));
+    }
+    {
+        // extraction would take the file for the alias index
+        archive_fixture::create_file((fs::path(archive_root) / ".myapps_alias").string(), 15);
+
+        uint64_t bad_total_size = 0;
+        solid_check(!myapps::utility::archive_create(archive_bad_path, archive_root, bad_total_size, dedup_options));
+        fs::remove(fs::path(archive_root) / ".myapps_alias", err);
+    }
+    return 0;
+}
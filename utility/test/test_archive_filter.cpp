@@ -0,0 +1,45 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const string archive_root           = "test_archive_filter_root";
+const string archive_path           = "test_archive_filter.zip";
+const string archive_filter_extract = "test_archive_filter_extract";
+} // namespace
+
+int test_archive_filter(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    archive_fixture::remove_all({archive_root, archive_path, archive_filter_extract});
+    archive_fixture::create_tree(archive_root);
+
+    uint64_t create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+
+    {
+        myapps::utility::ArchiveEntryFilter           filter;
+        std::vector<myapps::utility::ArchiveListEntry> list;
+        filter.patterns_ = {"first/"};
+        solid_check(myapps::utility::archive_list(archive_path, list, filter) && list.size() == 101);
+
+        // 100 files of 0 to 99 bytes, the directories above them come along
+        myapps::utility::ArchiveExtractOptions filter_options;
+        filter_options.filter_.patterns_ = {"second/third/*"};
+
+        uint64_t filter_total_size = 0;
+        solid_check(fs::create_directory(archive_filter_extract, err));
+        solid_check(myapps::utility::archive_extract(archive_path, archive_filter_extract, filter_total_size, filter_options));
+        solid_check(filter_total_size == 4950 && fs::exists(fs::path(archive_filter_extract) / "second" / "third" / "0063"));
+        solid_check(!fs::exists(fs::path(archive_filter_extract) / "first") && !fs::exists(fs::path(archive_filter_extract) / "second" / "0063"));
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "myapps/common/utility/archive_reader.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+const string archive_root       = "test_archive_list_root";
+const string archive_path       = "test_archive_list.zip";
+const string archive_solid_path = "test_archive_list_solid.zip";
+const string archive_late_path  = "test_archive_list_late.zip";
+} // namespace
+
+int test_archive_list(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+
+    archive_fixture::remove_all({archive_root, archive_path, archive_solid_path, archive_late_path});
+    archive_fixture::create_tree(archive_root);
+
+    myapps::utility::ArchiveCreateOptions solid_options;
+    solid_options.solid_file_size_ = 4 * 1024;
+
+    uint64_t create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+    solid_check(myapps::utility::archive_create(archive_solid_path, archive_root, create_total_size, solid_options));
+
+    // 100 files and the first/ and second/ directories at the root
+    std::vector<myapps::utility::ArchiveListEntry> entries;
+    solid_check(myapps::utility::archive_list(archive_path, "", entries) && entries.size() == 102);
+    solid_check(!myapps::utility::archive_list(archive_path, "third", entries));
+
+    // the same entries as the flat listing, mtimes included
+    std::vector<myapps::utility::ArchiveListEntry> flat;
+    solid_check(myapps::utility::archive_list(archive_path, flat));
+    solid_check(myapps::utility::archive_list(archive_path, "second/third", entries) && entries.size() == 100);
+    for (const auto& entry : entries) {
+        const auto it = std::find_if(flat.begin(), flat.end(), [&entry](const myapps::utility::ArchiveListEntry& _rentry) { return _rentry.name_ == "second/third/" + entry.name_; });
+        solid_check(it != flat.end() && it->size_ == entry.size_ && it->mtime_ == entry.mtime_ && entry.mtime_ != 0);
+    }
+
+    // solid members are listed like files, the cache keeps the listing index
+    myapps::utility::ArchiveCache       cache(8 * 1024);
+    myapps::utility::ArchiveListOptions list_options;
+    list_options.recursive_ = true;
+    list_options.pcache_    = &cache;
+    for (int i = 0; i < 2; ++i) {
+        solid_check(myapps::utility::archive_list(archive_solid_path, "/second", entries, list_options) && entries.size() == 201);
+        const auto it = std::find_if(entries.begin(), entries.end(), [](const myapps::utility::ArchiveListEntry& _rentry) { return _rentry.name_ == "third/0063"; });
+        solid_check(it != entries.end() && it->size_ == 99 && it->mtime_ != 0);
+    }
+    list_options.recursive_ = false;
+    solid_check(myapps::utility::archive_list(archive_solid_path, "second/", entries, list_options) && entries.size() == 101);
+
+    // an mtime past what a zip entry can hold (2200) is stored as its last second, in 2107
+    boost::filesystem::last_write_time(boost::filesystem::path(archive_root) / "0000", static_cast<time_t>(7258118400LL));
+    solid_check(myapps::utility::archive_create(archive_late_path, archive_root, create_total_size));
+    solid_check(myapps::utility::archive_list(archive_late_path, "", entries) && entries.size() == 102);
+    const auto it = std::find_if(entries.begin(), entries.end(), [](const myapps::utility::ArchiveListEntry& _rentry) { return _rentry.name_ == "0000"; });
+    solid_check(it != entries.end());
+    const struct tm* ptm = std::localtime(&it->mtime_);
+    solid_check(ptm->tm_year == 207 && ptm->tm_mon == 11 && ptm->tm_mday == 31 && ptm->tm_hour == 23 && ptm->tm_min == 59 && ptm->tm_sec == 58);
+    return 0;
+}
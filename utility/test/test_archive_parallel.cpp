@@ -0,0 +1,234 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "myapps/common/utility/archive_reader.hpp"
+#include "myapps/common/utility/encode.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+const string archive_root             = "test_archive_parallel_root";
+const string archive_parallel_path    = "test_archive_parallel.zip";
+const string archive_parallel_extract = "test_archive_parallel_extract";
+const string archive_digest_path      = "test_archive_digest.zip";
+const string archive_packed_path      = "test_archive_packed.zip";
+const string archive_callback_extract = "test_archive_callback_extract";
+const string archive_unsafe_path      = "test_archive_unsafe.zip";
+const string archive_unsafe_extract   = "test_archive_unsafe_extract";
+const string archive_escape           = "test_archive_escape";
+const string archive_sliced_root      = "test_archive_sliced_root";
+const string archive_sliced_path      = "test_archive_sliced.zip";
+const string archive_sliced_extract   = "test_archive_sliced_extract";
+
+// files of several 1KB slices: (name, content), compressible ones and random ones
+vector<pair<string, string>> sliced_files()
+{
+    mt19937 gen(11);
+    string  random(3 * 4096 + 17, '\0');
+    for (auto& c : random) {
+        c = static_cast<char>(gen());
+    }
+    string text;
+    while (text.size() < 40 * 1024 + 123) {
+        text += archive_fixture::pattern();
+    }
+    text.resize(40 * 1024 + 123);
+    return {{"random", random}, {"slices", text.substr(0, 2048)}, {"text", text}};
+}
+
+string read_file(const boost::filesystem::path& _path)
+{
+    ifstream ifs(_path.generic_string(), ios::binary);
+    return string((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+}
+
+// extracts the entries matching _patterns through the callbacks into memory, name -> content
+bool extract_to_map(const string& _path, const size_t _worker_count, const vector<string>& _patterns, map<string, string>& _rfiles, uint64_t& _rsize)
+{
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    fs::remove_all(archive_callback_extract, err);
+    solid_check(fs::create_directory(archive_callback_extract, err));
+
+    myapps::utility::ArchiveExtractOptions options;
+    options.worker_count_     = _worker_count;
+    options.filter_.patterns_ = _patterns;
+
+    _rfiles.clear();
+    _rsize = 0;
+    return myapps::utility::archive_extract(
+        _path, archive_callback_extract, _rsize, options,
+        [](const char*) { return true; },
+        [&_rfiles](const char* _name, uint64_t, const uint8_t*, uint16_t) {
+            string& rdata = _rfiles[_name];
+            return myapps::utility::FileWriteFunctionT([&rdata](const char* _data, size_t _size) {
+                rdata.append(_data, _size);
+                return true;
+            });
+        });
+}
+
+// every file of the tree under one of _dirs, with its content
+bool check_files(const map<string, string>& _files, std::initializer_list<const char*> _dirs)
+{
+    if (_files.size() != 100 * _dirs.size()) {
+        return false;
+    }
+    for (const char* dir : _dirs) {
+        for (size_t i = 0; i < 100; ++i) {
+            const auto it = _files.find(archive_fixture::file_name(dir, i));
+            if (it == _files.end() || it->second != archive_fixture::pattern().substr(0, i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+} // namespace
+
+int test_archive_parallel(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    archive_fixture::remove_all({archive_root, archive_parallel_path, archive_parallel_extract, archive_digest_path, archive_packed_path, archive_callback_extract, archive_unsafe_path, archive_unsafe_extract, archive_escape, archive_sliced_root, archive_sliced_path, archive_sliced_extract});
+    archive_fixture::create_tree(archive_root);
+
+    myapps::utility::ArchiveCreateOptions create_options;
+    create_options.worker_count_    = 4;
+    create_options.chunk_size_      = 1024;
+    create_options.read_ahead_size_ = 4 * 1024;
+
+    uint64_t parallel_create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_parallel_path, archive_root, parallel_create_total_size, create_options));
+
+    myapps::utility::ArchiveStatistics     extract_statistics;
+    myapps::utility::ArchiveExtractOptions extract_options;
+    extract_options.worker_count_ = 4;
+    extract_options.pobserver_    = extract_statistics.observer();
+
+    uint64_t parallel_extract_total_size = 0;
+    solid_check(fs::create_directory(archive_parallel_extract, err));
+    solid_check(myapps::utility::archive_extract(archive_parallel_path, archive_parallel_extract, parallel_extract_total_size, extract_options));
+    solid_check(parallel_create_total_size == archive_fixture::tree_size && parallel_extract_total_size == archive_fixture::tree_size);
+    solid_check(extract_statistics.entryCount() == 400 && extract_statistics.entrySize() == archive_fixture::tree_size);
+    solid_check(extract_statistics.bytes(myapps::utility::ArchivePhaseE::Write) == archive_fixture::tree_size);
+
+    {
+        // the callbacks, serial and parallel
+        map<string, string> files;
+        uint64_t            size = 0;
+        for (const size_t worker_count : {0, 4}) {
+            solid_check(extract_to_map(archive_parallel_path, worker_count, {}, files, size));
+            solid_check(size == archive_fixture::tree_size && check_files(files, {"", "first/", "second/", "second/third/"}));
+        }
+
+        // solid members come out of their block, duplicates fan out of their target; the
+        // filter takes members, aliases and plain files of one directory only
+        myapps::utility::ArchiveCreateOptions solid_options;
+        solid_options.solid_file_size_ = 4 * 1024;
+        myapps::utility::ArchiveCreateOptions dedup_options;
+        dedup_options.deduplicate_    = true;
+        dedup_options.write_manifest_ = true;
+
+        for (const auto* poptions : {&solid_options, &dedup_options}) {
+            uint64_t packed_create_total_size = 0;
+            fs::remove(archive_packed_path, err);
+            solid_check(myapps::utility::archive_create(archive_packed_path, archive_root, packed_create_total_size, *poptions));
+            for (const size_t worker_count : {0, 4}) {
+                solid_check(extract_to_map(archive_packed_path, worker_count, {}, files, size));
+                solid_check(size == archive_fixture::tree_size && check_files(files, {"", "first/", "second/", "second/third/"}));
+                solid_check(extract_to_map(archive_packed_path, worker_count, {"second/third/*"}, files, size));
+                solid_check(size == archive_fixture::tree_size / 4 && check_files(files, {"second/third/"}));
+            }
+        }
+    }
+
+    {
+        // files cut into slices compressed apart, each primed with the end of the previous one,
+        // their CRCs combined; a random file is stored whole
+        const auto files = sliced_files();
+        solid_check(fs::create_directory(archive_sliced_root, err));
+        for (const auto& file : files) {
+            ofstream((fs::path(archive_sliced_root) / file.first).generic_string(), ios::binary) << file.second;
+        }
+        myapps::utility::ArchiveCreateOptions sliced_options = create_options;
+        for (const size_t worker_count : {0, 4}) {
+            sliced_options.worker_count_ = worker_count;
+
+            uint64_t sliced_create_total_size = 0;
+            fs::remove(archive_sliced_path, err);
+            solid_check(myapps::utility::archive_create(archive_sliced_path, archive_sliced_root, sliced_create_total_size, sliced_options));
+
+            uint64_t sliced_extract_total_size = 0;
+            fs::remove_all(archive_sliced_extract, err);
+            solid_check(fs::create_directory(archive_sliced_extract, err));
+            solid_check(myapps::utility::archive_extract(archive_sliced_path, archive_sliced_extract, sliced_extract_total_size, extract_options));
+            solid_check(sliced_extract_total_size == sliced_create_total_size);
+
+            myapps::utility::ArchiveReader reader;
+            solid_check(reader.open(archive_sliced_path));
+            for (const auto& file : files) {
+                string data;
+                solid_check(read_file(fs::path(archive_sliced_extract) / file.first) == file.second);
+                solid_check(reader.readFile(file.first, data) && data == file.second);
+                solid_check(reader.readFile(file.first, 1000, 2000, data) && data == file.second.substr(1000, 2000));
+
+                const auto* pentry = reader.find(file.first);
+                solid_check(pentry != nullptr && (file.first == "random") == (pentry->method_ == 0));
+            }
+        }
+    }
+
+    {
+        // an archive with a name leaving the extraction root is refused before anything is written
+        for (const string& name : {"../" + archive_escape, "/" + archive_escape, "first/../" + archive_escape, "first\\..\\..\\" + archive_escape}) {
+            archive_fixture::create_stored_zip(archive_unsafe_path, {{"first/", ""}, {"first/0000", "data"}, {name, "data"}});
+
+            uint64_t unsafe_total_size = 0;
+            fs::remove_all(archive_unsafe_extract, err);
+            solid_check(fs::create_directory(archive_unsafe_extract, err));
+            solid_check(!myapps::utility::archive_extract(archive_unsafe_path, archive_unsafe_extract, unsafe_total_size));
+
+            myapps::utility::ArchiveExtractOptions unsafe_options;
+            for (const size_t worker_count : {0, 4}) {
+                unsafe_options.worker_count_ = worker_count;
+                solid_check(!myapps::utility::archive_extract(
+                    archive_unsafe_path, archive_unsafe_extract, unsafe_total_size, unsafe_options,
+                    [](const char*) { return true; },
+                    [](const char*, uint64_t, const uint8_t*, uint16_t) { return myapps::utility::FileWriteFunctionT([](const char*, size_t) { return true; }); }));
+            }
+            solid_check(!fs::exists(archive_escape) && !fs::exists(fs::path(archive_unsafe_extract) / "first"));
+        }
+    }
+
+    {
+        myapps::utility::ArchiveCreateOptions digest_options = create_options;
+        myapps::utility::ArchiveCreateResult  digest_result;
+        digest_options.compute_sha_sum_      = true;
+        digest_options.compute_file_digests_ = true;
+
+        uint64_t digest_total_size = 0;
+        solid_check(myapps::utility::archive_create(archive_digest_path, archive_root, digest_total_size, digest_options, digest_result));
+
+        ifstream ifs(archive_digest_path, ifstream::binary);
+        solid_check(digest_result.sha_sum_ == myapps::utility::sha256(ifs));
+        solid_check(digest_result.file_digests_.size() == 400);
+        for (const auto& file_digest : digest_result.file_digests_) {
+            if (file_digest.first == "first/0000") {
+                solid_check(file_digest.second == myapps::utility::sha256(string()));
+            }
+        }
+    }
+    return 0;
+}
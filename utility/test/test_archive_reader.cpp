@@ -0,0 +1,99 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "myapps/common/utility/archive_reader.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const string archive_root = "test_archive_reader_root";
+const string archive_path = "test_archive_reader.zip";
+const string archive_bad  = "test_archive_reader_bad.zip";
+const string archive_copy = "test_archive_reader_copy.zip";
+} // namespace
+
+int test_archive_reader(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    using archive_fixture::pattern;
+
+    archive_fixture::remove_all({archive_root, archive_path, archive_bad, archive_copy});
+    archive_fixture::create_tree(archive_root);
+
+    uint64_t create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+    boost::filesystem::copy_file(archive_path, archive_copy);
+
+    {
+        myapps::utility::ArchiveReader reader;
+        string                         data;
+        solid_check(reader.open(archive_path));
+        solid_check(reader.find("first/0063") != nullptr && reader.find("first/0064") == nullptr);
+        solid_check(reader.readFile("first/0063", data) && data.size() == 99);
+        solid_check(reader.readFile("first/0063", 10, 10, data) && data == pattern().substr(10, 10));
+    }
+
+    {
+        // a budget of 64KB for the index of 400 entries and a few arena blocks for their bytes
+        myapps::utility::ArchiveCache     cache(64 * 1024);
+        myapps::utility::ArchiveCacheData data;
+        solid_check(cache.readFile(archive_path, "first/0063", data) && data.view() == pattern().substr(0, 99));
+        solid_check(cache.readFile(archive_path, "first/0063", data) && cache.hitCount() == 1 && cache.missCount() == 1);
+        for (const char* dir : {"", "first/", "second/", "second/third/"}) {
+            for (size_t i = 0; i < 100; ++i) {
+                solid_check(cache.readFile(archive_path, archive_fixture::file_name(dir, i), data) && data.size_ == i);
+            }
+        }
+        solid_check(cache.size() <= cache.capacity() && cache.missCount() > 400);
+        solid_check(cache.readFile(archive_path, "first/0063", data) && data.view() == pattern().substr(0, 99));
+    }
+
+    {
+        // the indexes of both archives do not fit the budget together: the idle one is closed
+        myapps::utility::ArchiveCache     cache(64 * 1024);
+        myapps::utility::ArchiveCacheData data;
+        for (size_t i = 0; i < 4; ++i) {
+            for (const string& path : {archive_path, archive_copy}) {
+                solid_check(cache.readFile(path, archive_fixture::file_name("second/", 50), data) && data.view() == pattern().substr(0, 50));
+                solid_check(cache.imageCount() == 1 && cache.size() <= cache.capacity());
+            }
+        }
+        solid_check(cache.hitCount() == 0);
+    }
+
+    {
+        // with room for both, each keeps its index and its blocks until erased
+        myapps::utility::ArchiveCache     cache(1024 * 1024);
+        myapps::utility::ArchiveCacheData data;
+        for (size_t i = 0; i < 4; ++i) {
+            for (const string& path : {archive_path, archive_copy}) {
+                solid_check(cache.readFile(path, archive_fixture::file_name("second/", 50), data) && data.view() == pattern().substr(0, 50));
+            }
+        }
+        solid_check(cache.imageCount() == 2 && cache.hitCount() == 6 && cache.missCount() == 2);
+        const uint64_t size = cache.size();
+        cache.erase(archive_copy);
+        solid_check(cache.imageCount() == 1 && cache.size() > 0 && cache.size() < size);
+        cache.clear();
+        solid_check(cache.imageCount() == 0 && cache.size() == 0);
+    }
+
+    {
+        // end records claiming more entries than the directory can hold, or a directory past the end of the file
+        myapps::utility::ArchiveReader reader;
+        archive_fixture::create_zip64_end(archive_bad, uint64_t(1) << 60, 0, 0);
+        solid_check(!reader.open(archive_bad));
+        archive_fixture::create_zip64_end(archive_bad, 1, uint64_t(1) << 60, 0);
+        solid_check(!reader.open(archive_bad));
+        archive_fixture::create_zip64_end(archive_bad, 0, 46, ~uint64_t(0) - 10);
+        solid_check(!reader.open(archive_bad));
+
+        myapps::utility::ArchiveCache     cache(8 * 1024);
+        myapps::utility::ArchiveCacheData data;
+        solid_check(!cache.readFile(archive_bad, "first/0063", data));
+    }
+    return 0;
+}
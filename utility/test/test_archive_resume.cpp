@@ -0,0 +1,47 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const string archive_root           = "test_archive_resume_root";
+const string archive_path           = "test_archive_resume.zip";
+const string archive_resume_extract = "test_archive_resume_extract";
+const string archive_resume_journal = "test_archive_resume.journal";
+} // namespace
+
+int test_archive_resume(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    archive_fixture::remove_all({archive_root, archive_path, archive_resume_extract, archive_resume_journal});
+    archive_fixture::create_tree(archive_root);
+
+    uint64_t create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+
+    {
+        // a directory in the way of a file interrupts the extraction, the rerun resumes it
+        myapps::utility::ArchiveExtractOptions resume_options;
+        resume_options.journal_path_ = archive_resume_journal;
+
+        const fs::path obstacle          = fs::path(archive_resume_extract) / "second" / "third" / "0063";
+        uint64_t       resume_total_size = 0;
+        solid_check(fs::create_directories(obstacle, err));
+        solid_check(!myapps::utility::archive_extract(archive_path, archive_resume_extract, resume_total_size, resume_options));
+        solid_check(fs::file_size(archive_resume_journal) != 0);
+        fs::remove(obstacle);
+
+        resume_total_size = 0;
+        solid_check(myapps::utility::archive_extract(archive_path, archive_resume_extract, resume_total_size, resume_options));
+        solid_check(resume_total_size == create_total_size && !fs::exists(archive_resume_journal));
+        solid_check(fs::file_size(obstacle) == 99);
+    }
+    return 0;
+}
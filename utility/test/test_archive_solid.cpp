@@ -0,0 +1,126 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <initializer_list>
+#include <iostream>
+#include <tuple>
+
+using namespace std;
+
+namespace {
+const string archive_root          = "test_archive_solid_root";
+const string archive_path          = "test_archive_solid_plain.zip";
+const string archive_solid_path    = "test_archive_solid.zip";
+const string archive_solid_extract = "test_archive_solid_extract";
+const string archive_bad_path      = "test_archive_solid_bad.zip";
+const string archive_bad_extract   = "test_archive_solid_bad_extract";
+
+// a solid index of (name, size, block, offset) members
+string solid_index(std::initializer_list<std::tuple<string, uint64_t, uint32_t, uint64_t>> _members)
+{
+    string data;
+    archive_fixture::store(data, 0x31494d53, 4);
+    archive_fixture::store(data, _members.size(), 4);
+    for (const auto& member : _members) {
+        archive_fixture::store(data, std::get<0>(member).size(), 2);
+        data += std::get<0>(member);
+        archive_fixture::store(data, std::get<1>(member), 8);
+        archive_fixture::store(data, 0, 8);
+        archive_fixture::store(data, std::get<2>(member), 4);
+        archive_fixture::store(data, std::get<3>(member), 8);
+        archive_fixture::store(data, 0, 2);
+    }
+    return data;
+}
+} // namespace
+
+int test_archive_solid(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    archive_fixture::remove_all({archive_root, archive_path, archive_solid_path, archive_solid_extract, archive_bad_path, archive_bad_extract});
+    archive_fixture::create_tree(archive_root);
+
+    const fs::path archive_root_path(archive_root);
+
+    myapps::utility::ArchiveCreateOptions solid_options;
+    solid_options.solid_file_size_ = 4 * 1024;
+    solid_options.write_manifest_  = true;
+
+    uint64_t solid_create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_solid_path, archive_root, solid_create_total_size, solid_options));
+
+    uint64_t solid_extract_total_size = 0;
+    solid_check(fs::create_directory(archive_solid_extract, err));
+    solid_check(myapps::utility::archive_extract(archive_solid_path, archive_solid_extract, solid_extract_total_size));
+    solid_check(solid_create_total_size == archive_fixture::tree_size && solid_extract_total_size == archive_fixture::tree_size);
+    solid_check(fs::file_size(archive_root_path / "second" / "third" / "0063") == fs::file_size(fs::path(archive_solid_extract) / "second" / "third" / "0063"));
+    {
+        // 3 directories and 400 files, solid members included
+        std::vector<myapps::utility::ArchiveManifestEntry> manifest;
+        solid_check(myapps::utility::archive_read_manifest(archive_solid_path, manifest) && manifest.size() == 403);
+
+        uint64_t create_total_size = 0;
+        solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+        solid_check(!myapps::utility::archive_read_manifest(archive_path, manifest));
+
+        // a source file that extraction would take for the manifest is refused, with or without one
+        const fs::path reserved_path = archive_root_path / ".myapps_manifest";
+        archive_fixture::create_file(reserved_path.generic_string(), 15);
+        fs::remove(archive_path, err);
+        solid_check(!myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+        solid_check(!myapps::utility::archive_create(archive_path, archive_root, create_total_size, solid_options));
+        fs::remove(reserved_path, err);
+    }
+
+    {
+        // a meta too long for a plain entry is refused for a solid member as well
+        const auto big_meta_fnc = [](const std::string& _path, std::vector<uint8_t>& _rmeta) {
+            if (_path.find("second/third/0063") != std::string::npos) {
+                _rmeta.resize(70000);
+            }
+        };
+        uint64_t big_meta_total_size = 0;
+        fs::remove(archive_bad_path, err);
+        solid_check(!myapps::utility::archive_create(archive_bad_path, archive_root, big_meta_total_size, solid_options, big_meta_fnc));
+        fs::remove(archive_bad_path, err);
+        solid_check(!myapps::utility::archive_create(archive_bad_path, archive_root, big_meta_total_size, myapps::utility::ArchiveCreateOptions(), big_meta_fnc));
+    }
+
+    {
+        // members are sorted by block and follow each other in their block from offset 0
+        uint64_t bad_total_size = 0;
+        archive_fixture::create_stored_zip(
+            archive_bad_path, {{".myapps_solid/index", solid_index({{"a", 4, 0, 0}, {"b", 4, 0, 4}, {"c", 2, 1, 0}})}, {".myapps_solid/0", "abcdefgh"}, {".myapps_solid/1", "ij"}});
+        solid_check(fs::create_directory(archive_bad_extract, err));
+        solid_check(myapps::utility::archive_extract(archive_bad_path, archive_bad_extract, bad_total_size));
+        solid_check(bad_total_size == 10 && fs::file_size(fs::path(archive_bad_extract) / "b") == 4);
+
+        for (const auto& index : {
+                 solid_index({{"a", 4, 0, 0}, {"b", 4, 0, 5}, {"c", 2, 1, 0}}),
+                 solid_index({{"a", 4, 0, 1}, {"b", 4, 0, 5}, {"c", 2, 1, 0}}),
+                 solid_index({{"c", 2, 1, 0}, {"a", 4, 0, 0}, {"b", 4, 0, 4}})}) {
+            archive_fixture::create_stored_zip(archive_bad_path, {{".myapps_solid/index", index}, {".myapps_solid/0", "abcdefgh"}, {".myapps_solid/1", "ij"}});
+            fs::remove_all(archive_bad_extract, err);
+            solid_check(fs::create_directory(archive_bad_extract, err));
+            solid_check(!myapps::utility::archive_extract(archive_bad_path, archive_bad_extract, bad_total_size));
+        }
+    }
+
+    {
+        // a source file that extraction would take for a block is refused
+        const fs::path reserved_path = archive_root_path / ".myapps_solid";
+        solid_check(fs::create_directory(reserved_path, err));
+        archive_fixture::create_file((reserved_path / "0").generic_string(), 10);
+
+        uint64_t reserved_total_size = 0;
+        fs::remove(archive_bad_path, err);
+        solid_check(!myapps::utility::archive_create(archive_bad_path, archive_root, reserved_total_size));
+        fs::remove_all(reserved_path, err);
+    }
+    return 0;
+}
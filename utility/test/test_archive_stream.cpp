@@ -0,0 +1,69 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const string archive_root           = "test_archive_stream_root";
+const string archive_stream_path    = "test_archive_stream.zip";
+const string archive_stream_extract = "test_archive_stream_extract";
+const string archive_push_extract   = "test_archive_push_extract";
+const string archive_unsafe_path    = "test_archive_stream_unsafe.zip";
+const string archive_unsafe_extract = "test_archive_stream_unsafe_extract";
+const string archive_escape         = "test_archive_stream_escape";
+} // namespace
+
+int test_archive_stream(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    archive_fixture::remove_all({archive_root, archive_stream_path, archive_stream_extract, archive_push_extract, archive_unsafe_path, archive_unsafe_extract, archive_escape});
+    archive_fixture::create_tree(archive_root);
+
+    myapps::utility::ArchiveCreateOptions create_options;
+    create_options.worker_count_    = 4;
+    create_options.chunk_size_      = 1024;
+    create_options.read_ahead_size_ = 4 * 1024;
+
+    uint64_t stream_create_total_size = 0;
+    {
+        ofstream ofs(archive_stream_path, ofstream::binary);
+        solid_check(myapps::utility::archive_stream_create(ofs, archive_root, stream_create_total_size, create_options));
+    }
+
+    uint64_t stream_extract_total_size = 0;
+    solid_check(fs::create_directory(archive_stream_extract, err));
+    solid_check(myapps::utility::archive_extract(archive_stream_path, archive_stream_extract, stream_extract_total_size));
+    solid_check(stream_create_total_size == archive_fixture::tree_size && stream_extract_total_size == archive_fixture::tree_size);
+
+    solid_check(fs::create_directory(archive_push_extract, err));
+    {
+        myapps::utility::ArchiveStreamExtractor extractor(archive_push_extract);
+        ifstream                                ifs(archive_stream_path, ifstream::binary);
+        char                                    buf[4 * 1024];
+        while (ifs.read(buf, sizeof(buf)) || ifs.gcount() != 0) {
+            solid_check(extractor.push(buf, ifs.gcount()));
+        }
+        solid_check(extractor.done() && extractor.uncompressedSize() == archive_fixture::tree_size);
+    }
+
+    {
+        // a streamed archive is extracted as it arrives, up to the entry leaving the root
+        archive_fixture::create_stored_zip(archive_unsafe_path, {{"first/", ""}, {"first/0000", "data"}, {"../" + archive_escape, "data"}});
+        solid_check(fs::create_directory(archive_unsafe_extract, err));
+
+        myapps::utility::ArchiveStreamExtractor extractor(archive_unsafe_extract);
+        ifstream                                ifs(archive_unsafe_path, ifstream::binary);
+        const string                            data((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+        solid_check(!extractor.push(data.data(), data.size()) && extractor.failed());
+        solid_check(!fs::exists(archive_escape) && fs::exists(fs::path(archive_unsafe_extract) / "first" / "0000"));
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "myapps/common/utility/archive_reader.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const string archive_root           = "test_archive_update_root";
+const string archive_path           = "test_archive_update_base.zip";
+const string archive_update_path    = "test_archive_update.zip";
+const string archive_update_extract = "test_archive_update_extract";
+} // namespace
+
+int test_archive_update(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    archive_fixture::remove_all({archive_root, archive_path, archive_update_path, archive_update_extract});
+    archive_fixture::create_tree(archive_root);
+
+    uint64_t create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+
+    // one file added, one modified with the same size, one removed
+    const fs::path modified_path = fs::path(archive_root) / "first" / "0063";
+    archive_fixture::create_file((fs::path(archive_root) / "second" / "changed").generic_string(), 3 * 1024);
+    {
+        const time_t mtime = fs::last_write_time(modified_path);
+        ofstream     ofs(modified_path.generic_string(), ios::binary);
+        ofs << string(99, '#');
+        ofs.close();
+        fs::last_write_time(modified_path, mtime + 10);
+    }
+    fs::remove(fs::path(archive_root) / "second" / "0010");
+
+    myapps::utility::ArchiveStatistics    statistics;
+    myapps::utility::ArchiveUpdateOptions update_options;
+    update_options.create_.pobserver_ = statistics.observer();
+
+    uint64_t update_total_size = 0;
+    solid_check(myapps::utility::archive_update(archive_path, archive_root, archive_update_path, update_total_size, update_options));
+    solid_check(update_total_size == create_total_size + 3 * 1024 - 16);
+    // only the added and the modified files were read and compressed
+    solid_check(statistics.bytes(myapps::utility::ArchivePhaseE::Read) == 3 * 1024 + 99);
+    solid_check(statistics.bytes(myapps::utility::ArchivePhaseE::Compress) == 3 * 1024 + 99);
+
+    myapps::utility::ArchiveReader old_reader;
+    myapps::utility::ArchiveReader new_reader;
+    solid_check(old_reader.open(archive_path) && new_reader.open(archive_update_path));
+    solid_check(new_reader.entryCount() == old_reader.entryCount() && new_reader.find("second/0010") == nullptr);
+
+    // every other entry was copied as stored: the data at its new offset is the old data
+    size_t copied_count = 0;
+    for (size_t i = 0; i < new_reader.entryCount(); ++i) {
+        const auto& new_entry = new_reader.entry(i);
+        const auto* pold      = old_reader.find(new_entry.name_);
+        if (new_entry.isDirectory()) {
+            solid_check(pold != nullptr);
+            continue;
+        }
+        if (new_entry.name_ == "second/changed") {
+            solid_check(pold == nullptr);
+            continue;
+        }
+        solid_check(pold != nullptr && new_entry.size_ == pold->size_);
+        if (new_entry.name_ == "first/0063") {
+            solid_check(new_entry.crc_ != pold->crc_);
+            continue;
+        }
+        string new_data;
+        string old_data;
+        solid_check(new_entry.crc_ == pold->crc_ && new_entry.method_ == pold->method_ && new_entry.compressed_size_ == pold->compressed_size_);
+        solid_check(new_reader.readRaw(new_entry, new_data) && old_reader.readRaw(*pold, old_data) && new_data == old_data);
+        ++copied_count;
+    }
+    solid_check(copied_count == 4 * 100 - 2);
+
+    uint64_t update_extract_total_size = 0;
+    solid_check(fs::create_directory(archive_update_extract, err));
+    solid_check(myapps::utility::archive_extract(archive_update_path, archive_update_extract, update_extract_total_size));
+    solid_check(update_extract_total_size == update_total_size);
+    solid_check(!fs::exists(fs::path(archive_update_extract) / "second" / "0010"));
+
+    string data;
+    solid_check(new_reader.readFile("first/0063", data) && data == string(99, '#'));
+    return 0;
+}
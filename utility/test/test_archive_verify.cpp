@@ -0,0 +1,121 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/archive.hpp"
+#include "myapps/common/utility/archive_reader.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const string archive_root            = "test_archive_verify_root";
+const string archive_path            = "test_archive_verify.zip";
+const string archive_corrupt_path    = "test_archive_corrupt.zip";
+const string archive_corrupt_extract = "test_archive_corrupt_extract";
+const string archive_bad_path        = "test_archive_verify_bad.zip";
+const string archive_unsafe_path     = "test_archive_verify_unsafe.zip";
+const string archive_escape          = "test_archive_verify_escape";
+const string archive_big_root        = "test_archive_verify_big_root";
+const string archive_big_extract     = "test_archive_verify_big_extract";
+} // namespace
+
+int test_archive_verify(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    archive_fixture::remove_all({archive_root, archive_path, archive_corrupt_path, archive_corrupt_extract, archive_bad_path, archive_unsafe_path, archive_big_root, archive_big_extract});
+    archive_fixture::create_tree(archive_root);
+
+    uint64_t create_total_size = 0;
+    solid_check(myapps::utility::archive_create(archive_path, archive_root, create_total_size));
+
+    {
+        // one flipped byte inside an entry must fail the extraction
+        uint64_t data_offset = 0;
+        {
+            myapps::utility::ArchiveReader reader;
+            solid_check(reader.open(archive_path));
+            const auto* pentry = reader.find("second/third/0063");
+            solid_check(pentry != nullptr && reader.dataOffset(*pentry, data_offset));
+            data_offset += pentry->compressed_size_ / 2;
+        }
+        fs::copy_file(archive_path, archive_corrupt_path);
+        fstream file(archive_corrupt_path, fstream::in | fstream::out | fstream::binary);
+        char    c = 0;
+        file.seekg(data_offset);
+        file.get(c);
+        file.seekp(data_offset);
+        file.put(static_cast<char>(c ^ 0x10));
+        file.close();
+
+        uint64_t corrupt_total_size = 0;
+        solid_check(fs::create_directory(archive_corrupt_extract, err));
+        solid_check(!myapps::utility::archive_extract(archive_corrupt_path, archive_corrupt_extract, corrupt_total_size));
+
+        // the entry is stored: copied kernel side, then its CRC is checked
+        myapps::utility::ArchiveExtractOptions zero_copy_options;
+        zero_copy_options.zero_copy_ = true;
+
+        fs::remove_all(archive_corrupt_extract);
+        solid_check(fs::create_directory(archive_corrupt_extract, err));
+        solid_check(!myapps::utility::archive_extract(archive_corrupt_path, archive_corrupt_extract, corrupt_total_size, zero_copy_options));
+
+        myapps::utility::ArchiveVerifyResult verify_result;
+        solid_check(myapps::utility::archive_verify(archive_path, verify_result));
+        solid_check(verify_result.entry_count_ == 403 && verify_result.size_ == create_total_size);
+        solid_check(!myapps::utility::archive_verify(archive_corrupt_path, verify_result));
+        solid_check(verify_result.entry_name_ == "second/third/0063");
+    }
+
+    {
+        // a broken end record is reported, the archive as a whole
+        myapps::utility::ArchiveVerifyResult verify_result;
+        archive_fixture::create_zip64_end(archive_bad_path, uint64_t(1) << 60, 0, 0);
+        solid_check(!myapps::utility::archive_verify(archive_bad_path, verify_result));
+        solid_check(verify_result.entry_name_.empty() && !verify_result.error_.empty());
+    }
+
+    {
+        // names leaving the extraction root are reported by name, ".." inside a component is fine
+        myapps::utility::ArchiveVerifyResult verify_result;
+        for (const string& name : {"../" + archive_escape, "/" + archive_escape, "first/../" + archive_escape, "first\\..\\..\\" + archive_escape}) {
+            archive_fixture::create_stored_zip(archive_unsafe_path, {{"first/0000", "data"}, {name, "data"}});
+            solid_check(!myapps::utility::archive_verify(archive_unsafe_path, verify_result) && verify_result.entry_name_ == name);
+        }
+        archive_fixture::create_stored_zip(archive_unsafe_path, {{"first/0000", "data"}, {"first/..data", "data"}});
+        solid_check(myapps::utility::archive_verify(archive_unsafe_path, verify_result) && verify_result.entry_count_ == 2);
+    }
+
+    {
+        // a deflated entry inflating past the size of its central record fails without more
+        // than that size written out
+        solid_check(fs::create_directory(archive_big_root, err));
+        fs::remove(archive_bad_path, err);
+        ofstream((fs::path(archive_big_root) / "big").generic_string(), ios::binary) << string(64 * 1024, 'a');
+        solid_check(myapps::utility::archive_create(archive_bad_path, archive_big_root, create_total_size));
+
+        ifstream ifs(archive_bad_path, ios::binary);
+        string   data((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+        ifs.close();
+        const size_t central_offset = data.rfind(string("PK\x01\x02", 4));
+        solid_check(central_offset != string::npos && data.compare(central_offset + 46, 3, "big") == 0);
+        string size;
+        archive_fixture::store(size, 100, 4);
+        data.replace(central_offset + 24, 4, size);
+        ofstream(archive_bad_path, ios::binary | ios::trunc) << data;
+
+        myapps::utility::ArchiveVerifyResult verify_result;
+        solid_check(!myapps::utility::archive_verify(archive_bad_path, verify_result) && verify_result.entry_name_ == "big");
+
+        uint64_t big_total_size = 0;
+        solid_check(fs::create_directory(archive_big_extract, err));
+        solid_check(!myapps::utility::archive_extract(archive_bad_path, archive_big_extract, big_total_size));
+        const auto big_path = fs::path(archive_big_extract) / "big";
+        solid_check(!fs::exists(big_path) || fs::file_size(big_path) <= 100);
+    }
+    return 0;
+}
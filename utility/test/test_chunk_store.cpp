@@ -0,0 +1,125 @@
+#include "archive_fixture.hpp"
+#include "myapps/common/utility/chunk_store.hpp"
+#include "solid/system/exception.hpp"
+#include "solid/system/log.hpp"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+namespace {
+const string chunk_root          = "test_chunk_root";
+const string chunk_store_path    = "test_chunk_store";
+const string chunk_manifest_path = "test_chunk_manifest";
+const string chunk_extract       = "test_chunk_extract";
+
+// 1MB that no other file shares, cut into several chunks
+const size_t big_size = 1024 * 1024;
+
+void create_big_file(const string& _path)
+{
+    mt19937 gen(7);
+    string  data(big_size, '\0');
+    for (auto& c : data) {
+        c = static_cast<char>(gen());
+    }
+    ofstream ofs(_path, ios::binary);
+    ofs.write(data.data(), data.size());
+}
+
+string read_file(const boost::filesystem::path& _path)
+{
+    ifstream ifs(_path.generic_string(), ios::binary);
+    return string((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+}
+
+// a manifest holding one file entry without chunks
+string manifest(const string& _name, const uint64_t _size)
+{
+    string data = "myapps.chunks";
+    archive_fixture::store(data, 1, 4);
+    archive_fixture::store(data, 1, 8);
+    data += '\1';
+    archive_fixture::store(data, _name.size(), 2);
+    data += _name;
+    archive_fixture::store(data, 0, 8);
+    archive_fixture::store(data, _size, 8);
+    archive_fixture::store(data, 0, 2);
+    archive_fixture::store(data, 0, 4);
+    return data;
+}
+
+void overwrite(const string& _path, const size_t _offset, const string& _data)
+{
+    fstream fs(_path, ios::binary | ios::in | ios::out);
+    fs.seekp(_offset);
+    fs.write(_data.data(), _data.size());
+}
+} // namespace
+
+int test_chunk_store(int argc, char* argv[])
+{
+    solid::log_start(std::cerr, {".*:EW"});
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code err;
+    const string              manifests[] = {chunk_manifest_path + "_0", chunk_manifest_path + "_1", chunk_manifest_path + "_2", chunk_manifest_path + "_3"};
+    archive_fixture::remove_all({chunk_root, chunk_store_path, manifests[0], manifests[1], manifests[2], manifests[3], chunk_extract});
+    archive_fixture::create_tree(chunk_root);
+
+    uint64_t                              total_size = 0;
+    myapps::utility::ChunkStoreStatistics tree_statistics;
+    solid_check(myapps::utility::chunk_store_create(chunk_store_path, manifests[0], chunk_root, total_size, tree_statistics));
+    solid_check(total_size == archive_fixture::tree_size && tree_statistics.new_chunk_count_ != 0 && tree_statistics.new_chunk_count_ <= tree_statistics.chunk_count_);
+
+    // a second build with one more file: only the chunks of that file are new
+    const string big_path = (fs::path(chunk_root) / "second" / "big").generic_string();
+    create_big_file(big_path);
+
+    myapps::utility::ChunkStoreStatistics big_statistics;
+    solid_check(myapps::utility::chunk_store_create(chunk_store_path, manifests[1], chunk_root, total_size, big_statistics));
+    const uint64_t big_chunk_count = big_statistics.chunk_count_ - tree_statistics.chunk_count_;
+    solid_check(total_size == archive_fixture::tree_size + big_size && big_chunk_count >= big_size / (256 * 1024));
+    solid_check(big_statistics.new_chunk_count_ == big_chunk_count && big_statistics.new_chunk_size_ >= big_size);
+
+    // a small file changed to content of its own: its single chunk is new, the rest is reused
+    overwrite((fs::path(chunk_root) / "first" / "0063").generic_string(), 0, string(99, '#'));
+
+    myapps::utility::ChunkStoreStatistics small_statistics;
+    solid_check(myapps::utility::chunk_store_create(chunk_store_path, manifests[2], chunk_root, total_size, small_statistics));
+    solid_check(small_statistics.chunk_count_ == big_statistics.chunk_count_ && small_statistics.new_chunk_count_ == 1 && small_statistics.new_chunk_size_ <= 99);
+
+    // bytes changed in the middle of the big file: the chunk holding them is new, and the one
+    // after it when the boundary moved; the cut points resynchronize after that
+    overwrite(big_path, big_size / 2, string(100, '#'));
+
+    myapps::utility::ChunkStoreStatistics edit_statistics;
+    solid_check(myapps::utility::chunk_store_create(chunk_store_path, manifests[3], chunk_root, total_size, edit_statistics));
+    solid_check(edit_statistics.new_chunk_count_ >= 1 && edit_statistics.new_chunk_count_ <= 2);
+    solid_check(edit_statistics.new_chunk_size_ < big_statistics.new_chunk_size_ / 2);
+
+    uint64_t extract_total_size = 0;
+    solid_check(fs::create_directory(chunk_extract, err));
+    solid_check(myapps::utility::chunk_store_extract(chunk_store_path, manifests[3], chunk_extract, extract_total_size));
+    solid_check(extract_total_size == archive_fixture::tree_size + big_size);
+    for (const auto& item : fs::recursive_directory_iterator(chunk_root)) {
+        if (fs::is_regular_file(item.path())) {
+            const auto extracted = fs::path(chunk_extract) / fs::relative(item.path(), chunk_root);
+            solid_check(read_file(extracted) == read_file(item.path()));
+        }
+    }
+
+    // an escaping name or chunks not adding up to the entry size reject the manifest
+    for (const auto& data : {manifest("../evil", 0), manifest("evil", 10)}) {
+        ofstream(manifests[0], ios::binary | ios::trunc) << data;
+
+        uint64_t bad_total_size = 0;
+        fs::remove_all(chunk_extract, err);
+        solid_check(fs::create_directory(chunk_extract, err));
+        solid_check(!myapps::utility::chunk_store_extract(chunk_store_path, manifests[0], chunk_extract, bad_total_size));
+        solid_check(!fs::exists(fs::path(chunk_extract) / "evil") && !fs::exists("evil"));
+    }
+    return 0;
+}